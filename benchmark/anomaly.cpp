@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// K-means anomaly scoring against random clusters: the linear scan (get_min_distance_to_cluster,
+// which the SDK doesn't compile with EI_CLASSIFIER_ANOMALY_SOA/TREE, so linear_min_distance below)
+// vs the structure-of-arrays kernel (get_min_distance_to_cluster_soa, built with
+// EI_CLASSIFIER_ANOMALY_SOA=1) and the batch kernel (get_min_distance_to_cluster_batch).
+// anomaly_tree is built with EI_CLASSIFIER_ANOMALY_TREE=1, and times the ball tree
+// (get_min_distance_to_cluster_tree) instead of the SoA kernel.
+// Times are per input; "mismatches" counts scores that aren't bit exact with the linear scan.
+
+// clusters with up to 33 axes, instead of the ones of the model
+#define _EI_CLASSIFIER_ANOMALY_TYPES_HEADER_H_
+#define EI_CLASSIFIER_ANOM_AXIS_SIZE 33
+typedef struct {
+    float centroid[EI_CLASSIFIER_ANOM_AXIS_SIZE];
+    float max_error;
+} ei_classifier_anom_cluster_t;
+
+#include "edge-impulse-sdk/anomaly/anomaly.h"
+#include "bench_common.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+// get_min_distance_to_cluster
+static float linear_min_distance(float *input, size_t input_size, const ei_classifier_anom_cluster_t *clusters,
+                                 size_t cluster_size) {
+    float min = 1000.0f;
+    for (size_t ix = 0; ix < cluster_size; ix++) {
+        float dist = calculate_cluster_distance(input, input_size, &clusters[ix]);
+        if (dist < min) {
+            min = dist;
+        }
+    }
+    return min;
+}
+
+static void run(size_t input_size, size_t cluster_count, int reps) {
+    std::mt19937 rng(1);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+    std::vector<ei_classifier_anom_cluster_t> clusters(cluster_count);
+    for (auto &cluster : clusters) {
+        for (size_t ix = 0; ix < input_size; ix++) {
+            cluster.centroid[ix] = normal(rng) * 1.5f + 4.0f;
+        }
+        cluster.max_error = uniform(rng) * 0.8f;
+    }
+
+    std::vector<float> soa_buffer(EI_CLASSIFIER_ANOM_SOA_SIZE(input_size, cluster_count));
+    ei_classifier_anom_clusters_soa_t soa;
+    init_clusters_soa(&soa, clusters.data(), cluster_count, input_size, soa_buffer.data());
+
+#if EI_CLASSIFIER_ANOMALY_TREE == 1
+    std::vector<ei_classifier_anom_tree_node_t> nodes(EI_CLASSIFIER_ANOM_TREE_MAX_NODES(cluster_count));
+    std::vector<float> centers(input_size * nodes.size());
+    std::vector<uint32_t> index(cluster_count);
+    ei_classifier_anom_tree_t tree;
+    init_clusters_tree(&tree, clusters.data(), cluster_count, input_size, nodes.data(), centers.data(), index.data());
+#endif
+
+    // raw features on a centroid, close to one, and far from all of them, scaled with
+    // standard_scaler like inference_anomaly_invoke does
+    std::vector<float> scale(input_size), mean(input_size);
+    for (size_t ix = 0; ix < input_size; ix++) {
+        scale[ix] = 0.5f + uniform(rng) * 4.0f;
+        mean[ix] = normal(rng) * 5.0f;
+    }
+    const size_t input_count = 16;
+    std::vector<float> inputs(input_count * input_size);
+    for (size_t row = 0; row < input_count; row++) {
+        const ei_classifier_anom_cluster_t *cluster = &clusters[(row * 7) % cluster_count];
+        for (size_t ix = 0; ix < input_size; ix++) {
+            float value = cluster->centroid[ix];
+            if (row % 3 == 1) {
+                value += normal(rng) * 0.3f;
+            }
+            else if (row % 3 == 2) {
+                value = normal(rng) * 3.0f;
+            }
+            inputs[(row * input_size) + ix] = (value * scale[ix]) + mean[ix];
+        }
+        standard_scaler(&inputs[row * input_size], scale.data(), mean.data(), input_size);
+    }
+
+    std::vector<float> linear(input_count), batch(input_count);
+#if EI_CLASSIFIER_ANOMALY_TREE == 1
+    std::vector<float> tree_scores(input_count);
+#elif EI_CLASSIFIER_ANOMALY_SOA == 1
+    std::vector<float> soa_scores(input_count);
+#endif
+
+    uint64_t linear_ns = bench_best_ns(reps, [&] {
+        for (size_t row = 0; row < input_count; row++) {
+            linear[row] = linear_min_distance(
+                &inputs[row * input_size], input_size, clusters.data(), cluster_count);
+        }
+        bench_sink = linear[0];
+    });
+#if EI_CLASSIFIER_ANOMALY_TREE == 1
+    uint64_t tree_ns = bench_best_ns(reps, [&] {
+        for (size_t row = 0; row < input_count; row++) {
+            tree_scores[row] = get_min_distance_to_cluster_tree(&inputs[row * input_size], &tree);
+        }
+        bench_sink = tree_scores[0];
+    });
+#elif EI_CLASSIFIER_ANOMALY_SOA == 1
+    uint64_t soa_ns = bench_best_ns(reps, [&] {
+        for (size_t row = 0; row < input_count; row++) {
+            soa_scores[row] = get_min_distance_to_cluster_soa(&inputs[row * input_size], &soa);
+        }
+        bench_sink = soa_scores[0];
+    });
+#endif
+    uint64_t batch_ns = bench_best_ns(reps, [&] {
+        get_min_distance_to_cluster_batch(inputs.data(), input_count, &soa, batch.data());
+        bench_sink = batch[0];
+    });
+
+    int mismatches = 0;
+    for (size_t row = 0; row < input_count; row++) {
+        mismatches += memcmp(&linear[row], &batch[row], sizeof(float)) != 0;
+#if EI_CLASSIFIER_ANOMALY_TREE == 1
+        mismatches += memcmp(&linear[row], &tree_scores[row], sizeof(float)) != 0;
+#elif EI_CLASSIFIER_ANOMALY_SOA == 1
+        mismatches += memcmp(&linear[row], &soa_scores[row], sizeof(float)) != 0;
+#endif
+    }
+
+    printf("%zu axes x %zu clusters, mismatches %d\n", input_size, cluster_count, mismatches);
+    bench_print("  linear", linear_ns / input_count);
+#if EI_CLASSIFIER_ANOMALY_TREE == 1
+    bench_print("  tree", tree_ns / input_count);
+#elif EI_CLASSIFIER_ANOMALY_SOA == 1
+    bench_print("  soa", soa_ns / input_count);
+#endif
+    bench_print("  batch", batch_ns / input_count);
+}
+
+int main() {
+    run(3, 32, 20000);
+    run(3, 256, 5000);
+    run(16, 100, 5000);
+    run(33, 1024, 500);
+    return 0;
+}
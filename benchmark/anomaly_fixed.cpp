@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// K-means anomaly scoring of the model in fixed point (EI_CLASSIFIER_ANOMALY_FIXED_POINT, built
+// as anomaly_fixed8 and anomaly_fixed16) against the float scaler and linear scan, which the SDK
+// doesn't compile in fixed-point builds, so float_score below.
+// On a host with an FPU the float scoring is the faster one, fixed point is for targets without one.
+// Checks model-parameters/anomaly_clusters_fixed.h against anomaly_clusters.h: "over tolerance"
+// counts scores further than EI_CLASSIFIER_ANOM_FIXED_TOLERANCE from the float score (features
+// that saturate may only lower the score). Times are per input.
+
+#include "model-parameters/model_metadata.h"
+#include "model-parameters/anomaly_clusters.h"
+#include "model-parameters/anomaly_clusters_fixed.h"
+#include "bench_common.h"
+#include <random>
+#include <vector>
+
+#if EI_CLASSIFIER_ANOMALY_FIXED_POINT == 0
+#error "Build with EI_CLASSIFIER_ANOMALY_FIXED_POINT=8 or 16"
+#endif
+
+static const size_t input_size = EI_CLASSIFIER_ANOM_AXIS_SIZE;
+
+// standard_scaler and get_min_distance_to_cluster, scaled holds the scaled input
+static float float_score(const float *input, float *scaled) {
+    for (size_t ix = 0; ix < input_size; ix++) {
+        scaled[ix] = (input[ix] - ei_classifier_anom_mean[ix]) / ei_classifier_anom_scale[ix];
+    }
+    float min = 1000.0f;
+    for (size_t cx = 0; cx < EI_CLASSIFIER_ANOM_CLUSTER_COUNT; cx++) {
+        const ei_classifier_anom_cluster_t *cluster = &ei_classifier_anom_clusters[cx];
+        float dist = 0.0f;
+        for (size_t ix = 0; ix < input_size; ix++) {
+            dist += pow(scaled[ix] - cluster->centroid[ix], 2);
+        }
+        dist = sqrt(dist) - cluster->max_error;
+        if (dist < min) {
+            min = dist;
+        }
+    }
+    return min;
+}
+
+static float fixed_score(const float *input) {
+    int16_t scaled[EI_CLASSIFIER_ANOM_AXIS_SIZE];
+    standard_scaler_fixed(input, &ei_classifier_anom_clusters_fixed, scaled);
+    return get_min_distance_to_cluster_fixed(scaled, &ei_classifier_anom_clusters_fixed);
+}
+
+int main() {
+    const ei_classifier_anom_clusters_fixed_t *fixed = &ei_classifier_anom_clusters_fixed;
+    const double one = (double)(1 << fixed->frac_bits);
+
+    std::mt19937 rng(3);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+
+    // inputs around the mean, mostly close to the clusters, some far out and some huge
+    const size_t input_count = 200000;
+    std::vector<float> inputs(input_count * input_size);
+    for (size_t row = 0; row < input_count; row++) {
+        const float spread = (row % 10 == 0) ? 40.0f : (row % 3 ? 1.5f : 4.0f);
+        for (size_t ix = 0; ix < input_size; ix++) {
+            float value = ei_classifier_anom_mean[ix] + normal(rng) * ei_classifier_anom_scale[ix] * spread;
+            if (row % 1000 == 7) {
+                value = (row & 8) ? 1e30f : -1e30f;
+            }
+            inputs[(row * input_size) + ix] = value;
+        }
+    }
+
+    size_t over_tolerance = 0, saturated_count = 0;
+    double max_diff = 0.0;
+    for (size_t row = 0; row < input_count; row++) {
+        const float *input = &inputs[row * input_size];
+        float scaled[EI_CLASSIFIER_ANOM_AXIS_SIZE];
+        const float reference = float_score(input, scaled);
+        const float score = fixed_score(input);
+
+        bool saturated = false;
+        for (size_t ix = 0; ix < input_size; ix++) {
+            if (fabs(scaled[ix] * one) > fixed->limit - 1) {
+                saturated = true;
+            }
+        }
+        const double diff = (double)score - reference;
+        if (saturated) {
+            saturated_count++;
+            over_tolerance += diff > EI_CLASSIFIER_ANOM_FIXED_TOLERANCE;
+        }
+        else {
+            over_tolerance += fabs(diff) > EI_CLASSIFIER_ANOM_FIXED_TOLERANCE;
+            if (fabs(diff) > max_diff) {
+                max_diff = fabs(diff);
+            }
+        }
+    }
+
+    printf("int%d, %zu inputs (%zu saturated), over tolerance %zu, max difference %g (tolerance %g)\n",
+        EI_CLASSIFIER_ANOMALY_FIXED_POINT, input_count, saturated_count, over_tolerance, max_diff,
+        (double)EI_CLASSIFIER_ANOM_FIXED_TOLERANCE);
+
+    const size_t timed_count = 1000;
+    uint64_t float_ns = bench_best_ns(50, [&] {
+        float scaled[EI_CLASSIFIER_ANOM_AXIS_SIZE];
+        for (size_t row = 0; row < timed_count; row++) {
+            bench_sink = float_score(&inputs[row * input_size], scaled);
+        }
+    });
+    uint64_t fixed_ns = bench_best_ns(50, [&] {
+        for (size_t row = 0; row < timed_count; row++) {
+            bench_sink = fixed_score(&inputs[row * input_size]);
+        }
+    });
+    // per input, with one more decimal than bench_print
+    printf("%-40s %10.3f us\n", "  float", float_ns / 1000.0 / timed_count);
+    printf("%-40s %10.3f us\n", "  fixed", fixed_ns / 1000.0 / timed_count);
+
+    return over_tolerance == 0 ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _EI_BENCH_COMMON_H_
+#define _EI_BENCH_COMMON_H_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * Best of `reps` runs of fn, in nanoseconds. The best run is the least
+ * disturbed by the OS, so it's the most stable number between runs.
+ */
+template<typename F>
+static uint64_t bench_best_ns(int reps, F fn) {
+    uint64_t best = UINT64_MAX;
+    for (int rep = 0; rep < reps; rep++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        if (ns < best) {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+static inline void bench_print(const char *name, uint64_t ns) {
+    printf("%-40s %10.2f us\n", name, ns / 1000.0);
+}
+
+// keeps results alive, so the compiler doesn't drop the benchmarked code
+static volatile float bench_sink;
+
+#endif // _EI_BENCH_COMMON_H_
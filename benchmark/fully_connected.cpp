@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// int8 fully connected layers: the reference kernel (reference_integer_ops::FullyConnected)
+// vs the optimized one (optimized_integer_ops::FullyConnected), on the shapes of the model
+// (33 -> 20 -> 10 -> 4) and some larger ones. The optimized kernel uses SSE2 on x86-64,
+// build with BENCH_FLAGS=-mavx2 for the AVX2 path.
+// Before timing, every shape is checked against the reference kernel for a few input and
+// filter offsets, per tensor, per channel (FullyConnectedPerChannel) and without bias;
+// "mismatches" counts outputs that aren't bit exact.
+
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/optimized/integer_ops/fully_connected.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/quantization_util.h"
+#include "bench_common.h"
+#include <random>
+#include <vector>
+
+using namespace tflite;
+
+static std::mt19937 rng(3);
+static std::uniform_int_distribution<int> int8_values(-128, 127);
+
+static void fill(std::vector<int8_t> &values) {
+    for (auto &value : values) {
+        value = (int8_t)int8_values(rng);
+    }
+}
+
+static int check(int batches, int input_size, int output_size) {
+    int mismatches = 0;
+    const RuntimeShape input_shape({ batches, input_size }), filter_shape({ output_size, input_size });
+    const RuntimeShape bias_shape({ output_size }), output_shape({ batches, output_size });
+
+    for (int input_zero_point : { -128, 0, 5 }) {
+        for (int filter_zero_point : { 0, 3 }) {
+            std::vector<int8_t> input(batches * input_size), filter(output_size * input_size);
+            std::vector<int8_t> reference(batches * output_size), optimized(batches * output_size);
+            std::vector<int32_t> bias(output_size), multiplier(output_size), shift(output_size);
+            fill(input);
+            fill(filter);
+            for (int channel = 0; channel < output_size; channel++) {
+                bias[channel] = int8_values(rng) * 37;
+                int channel_shift;
+                QuantizeMultiplier(0.0003 * (1 + channel % 5) * 128.0 / input_size,
+                    &multiplier[channel], &channel_shift);
+                shift[channel] = channel_shift;
+            }
+
+            FullyConnectedParams params = { };
+            params.input_offset = -input_zero_point;
+            params.weights_offset = -filter_zero_point;
+            params.output_offset = -3;
+            params.output_multiplier = multiplier[0];
+            params.output_shift = shift[0];
+            params.quantized_activation_min = -128;
+            params.quantized_activation_max = 127;
+
+            reference_integer_ops::FullyConnected(params, input_shape, input.data(), filter_shape,
+                filter.data(), bias_shape, bias.data(), output_shape, reference.data());
+            optimized_integer_ops::FullyConnected(params, input_shape, input.data(), filter_shape,
+                filter.data(), bias_shape, bias.data(), output_shape, optimized.data());
+            for (size_t ix = 0; ix < reference.size(); ix++) {
+                mismatches += reference[ix] != optimized[ix];
+            }
+
+            // per channel, against the reference kernel on one channel at a time
+            optimized_integer_ops::FullyConnectedPerChannel(params, multiplier.data(), shift.data(),
+                input_shape, input.data(), filter_shape, filter.data(), bias_shape, bias.data(),
+                output_shape, optimized.data());
+            const RuntimeShape row_input_shape({ 1, input_size }), row_filter_shape({ 1, input_size });
+            const RuntimeShape row_bias_shape({ 1 }), row_output_shape({ 1, 1 });
+            for (int channel = 0; channel < output_size; channel++) {
+                FullyConnectedParams channel_params = params;
+                channel_params.output_multiplier = multiplier[channel];
+                channel_params.output_shift = shift[channel];
+                for (int batch = 0; batch < batches; batch++) {
+                    int8_t value;
+                    reference_integer_ops::FullyConnected(channel_params, row_input_shape,
+                        &input[batch * input_size], row_filter_shape, &filter[channel * input_size],
+                        row_bias_shape, &bias[channel], row_output_shape, &value);
+                    mismatches += value != optimized[(batch * output_size) + channel];
+                }
+            }
+
+            // without bias
+            reference_integer_ops::FullyConnected(params, input_shape, input.data(), filter_shape,
+                filter.data(), bias_shape, nullptr, output_shape, reference.data());
+            optimized_integer_ops::FullyConnected(params, input_shape, input.data(), filter_shape,
+                filter.data(), bias_shape, nullptr, output_shape, optimized.data());
+            for (size_t ix = 0; ix < reference.size(); ix++) {
+                mismatches += reference[ix] != optimized[ix];
+            }
+        }
+    }
+    return mismatches;
+}
+
+static void run(int batches, int input_size, int output_size) {
+    int mismatches = check(batches, input_size, output_size);
+
+    std::vector<int8_t> input(batches * input_size), filter(output_size * input_size);
+    std::vector<int8_t> output(batches * output_size);
+    std::vector<int32_t> bias(output_size);
+    fill(input);
+    fill(filter);
+
+    FullyConnectedParams params = { };
+    params.input_offset = 128;
+    params.output_multiplier = 1 << 30;
+    params.output_shift = -8;
+    params.quantized_activation_min = -128;
+    params.quantized_activation_max = 127;
+    const RuntimeShape input_shape({ batches, input_size }), filter_shape({ output_size, input_size });
+    const RuntimeShape bias_shape({ output_size }), output_shape({ batches, output_size });
+
+    // the small layers take well under a microsecond, so every timed run calls the kernel
+    // enough times to do ~1M multiply-adds
+    const long macs = (long)batches * input_size * output_size;
+    const int calls = (int)(1000000 / macs) + 1;
+
+    uint64_t reference_ns = bench_best_ns(50, [&] {
+        for (int call = 0; call < calls; call++) {
+            reference_integer_ops::FullyConnected(params, input_shape, input.data(), filter_shape,
+                filter.data(), bias_shape, bias.data(), output_shape, output.data());
+            bench_sink = output[0];
+        }
+    });
+    uint64_t optimized_ns = bench_best_ns(50, [&] {
+        for (int call = 0; call < calls; call++) {
+            optimized_integer_ops::FullyConnected(params, input_shape, input.data(), filter_shape,
+                filter.data(), bias_shape, bias.data(), output_shape, output.data());
+            bench_sink = output[0];
+        }
+    });
+
+    // per call times, with one more decimal than bench_print: the model layers take tens of ns
+    printf("%dx%d -> %d, mismatches %d, speedup x%.1f\n", batches, input_size, output_size,
+        mismatches, (double)reference_ns / optimized_ns);
+    printf("%-40s %10.3f us\n", "  reference", reference_ns / 1000.0 / calls);
+    printf("%-40s %10.3f us\n", "  optimized", optimized_ns / 1000.0 / calls);
+}
+
+int main() {
+    // the layers of the model
+    run(1, 33, 20);
+    run(1, 20, 10);
+    run(1, 10, 4);
+    // odd sizes (tails of the vector loops) and larger layers
+    run(1, 1, 1);
+    run(3, 17, 5);
+    run(1, 31, 7);
+    run(2, 64, 64);
+    run(1, 256, 128);
+    run(1, 640, 256);
+    run(4, 1024, 512);
+    return 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Generates model-parameters/anomaly_clusters_fixed.h (the clusters and scaler of
+// model-parameters/anomaly_clusters.h in fixed point, for EI_CLASSIFIER_ANOMALY_FIXED_POINT)
+// on stdout. Run make -C benchmark anomaly_clusters_fixed after exporting the model again.
+
+#include "model-parameters/model_metadata.h"
+#include "model-parameters/anomaly_clusters.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+static void print_header() {
+    printf(
+        "/* Copyright (c) 2022 EdgeImpulse Inc.\n"
+        " *\n"
+        " * Permission is hereby granted, free of charge, to any person obtaining a copy\n"
+        " * of this software and associated documentation files (the \"Software\"), to deal\n"
+        " * in the Software without restriction, including without limitation the rights\n"
+        " * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell\n"
+        " * copies of the Software, and to permit persons to whom the Software is\n"
+        " * furnished to do so, subject to the following conditions:\n"
+        " *\n"
+        " * The above copyright notice and this permission notice shall be included in\n"
+        " * all copies or substantial portions of the Software.\n"
+        " *\n"
+        " * THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR\n"
+        " * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,\n"
+        " * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE\n"
+        " * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER\n"
+        " * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,\n"
+        " * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE\n"
+        " * SOFTWARE.\n"
+        " */\n"
+        "\n"
+        "#ifndef _EI_CLASSIFIER_ANOMALY_CLUSTERS_FIXED_H_\n"
+        "#define _EI_CLASSIFIER_ANOMALY_CLUSTERS_FIXED_H_\n"
+        "\n"
+        "#include \"edge-impulse-sdk/anomaly/anomaly.h\"\n"
+        "\n"
+        "// Generated from anomaly_clusters.h by benchmark/gen_anomaly_clusters_fixed.cpp: the clusters\n"
+        "// and scaler in fixed point, for EI_CLASSIFIER_ANOMALY_FIXED_POINT (see\n"
+        "// ei_classifier_anom_clusters_fixed_t). Run make -C benchmark anomaly_clusters_fixed when the\n"
+        "// model is exported again; the static_asserts catch other cluster or axis counts, and\n"
+        "// benchmark/anomaly_fixed checks the scores against the float ones. Centroids and\n"
+        "// max errors are value * 2^frac_bits, rounded and saturated to the range of the type; frac_bits\n"
+        "// is the largest that fits twice the largest centroid.\n"
+        "// EI_CLASSIFIER_ANOM_FIXED_TOLERANCE is (sqrt(axes) * (1 + e) + 1) / 2^frac_bits: every axis is\n"
+        "// off by at most 1 + e (rounding the input and the centroid, e is the rounding of the integer\n"
+        "// scaler), plus 1 for rounding the square root and max_error. Saturated features only lower\n"
+        "// the score.\n"
+        "\n");
+}
+
+static void print_float_array(const char *name, const float *values, size_t size) {
+    printf("const float %s[] = { ", name);
+    for (size_t ix = 0; ix < size; ix++) {
+        printf("%s%.9g", ix ? ", " : "", values[ix]);
+    }
+    printf(" };\n");
+}
+
+static void print_tables(int bits) {
+    const size_t n = EI_CLASSIFIER_ANOM_AXIS_SIZE;
+    const size_t k = EI_CLASSIFIER_ANOM_CLUSTER_COUNT;
+    const int32_t limit = bits == 8 ? INT8_MAX : INT16_MAX;
+    const ei_classifier_anom_cluster_t *clusters = ei_classifier_anom_clusters;
+
+    // the largest frac_bits that fits twice the largest centroid
+    float range = 1.0f;
+    for (size_t cx = 0; cx < k; cx++) {
+        for (size_t ix = 0; ix < n; ix++) {
+            float value = 2.0f * fabsf(clusters[cx].centroid[ix]);
+            if (value > range) {
+                range = value;
+            }
+        }
+    }
+    int frac_bits = 0;
+    while (frac_bits < 24 && range * (float)(1 << (frac_bits + 1)) <= (float)limit) {
+        frac_bits++;
+    }
+    const float one = (float)(1 << frac_bits);
+
+    float input_limit[n], input_mul[n];
+    int32_t scaler_mul[n];
+    int64_t scaler_add[n];
+    int scaler_shift[n];
+    long double extra = 0; // extra rounding of the integer scaler, in fixed point units
+    for (size_t ix = 0; ix < n; ix++) {
+        const long double scale = ei_classifier_anom_scale[ix], mean = ei_classifier_anom_mean[ix];
+        const long double inv = ldexpl(1.0L, frac_bits) / scale;
+        // past mean +- (limit + 1) * scale / 2^frac_bits the scaled value saturates
+        const long double input_range = fabsl(mean) + (limit + 1) * scale / ldexpl(1.0L, frac_bits);
+        float lim = (float)input_range;
+        if ((long double)lim < input_range) {
+            lim = nextafterf(lim, INFINITY);
+        }
+        // input * input_mul < 2^30
+        int in_frac = 30;
+        while ((long double)lim * ldexpl(1.0L, in_frac) >= ldexpl(1.0L, 30)) {
+            in_frac--;
+        }
+        // scaler_mul in [2^30, 2^31)
+        int mul_frac = 30 - (int)floorl(log2l(inv));
+        long long mul = llroundl(inv * ldexpl(1.0L, mul_frac));
+        while (mul >= (1LL << 31)) {
+            mul_frac--;
+            mul = llroundl(inv * ldexpl(1.0L, mul_frac));
+        }
+        while (mul < (1LL << 30)) {
+            mul_frac++;
+            mul = llroundl(inv * ldexpl(1.0L, mul_frac));
+        }
+        const int shift = in_frac + mul_frac;
+        if (shift < 1 || shift > 62) {
+            fprintf(stderr, "scaler_shift of axis %zu out of range (%d)\n", ix, shift);
+            exit(1);
+        }
+        const long double add = -mean * inv * ldexpl(1.0L, shift);
+        if (fabsl(add) >= ldexpl(1.0L, 62)) {
+            fprintf(stderr, "scaler_add of axis %zu out of range\n", ix);
+            exit(1);
+        }
+        input_limit[ix] = lim;
+        input_mul[ix] = ldexpf(1.0f, in_frac);
+        scaler_mul[ix] = (int32_t)mul;
+        scaler_add[ix] = (int64_t)llroundl(add);
+        scaler_shift[ix] = shift;
+        // truncating the input, rounding scaler_mul (|value| < 2^30) and scaler_add
+        long double error = inv / ldexpl(1.0L, in_frac) + ldexpl(1.0L, 29 - shift) + ldexpl(1.0L, -1 - shift);
+        if (error > extra) {
+            extra = error;
+        }
+    }
+    double tolerance = (sqrt((double)n) * (1.0 + (double)extra) + 1.0) / ldexp(1.0, frac_bits);
+    // rounded up to 3 significant digits
+    char tolerance_str[32];
+    snprintf(tolerance_str, sizeof(tolerance_str), "%.3g", tolerance);
+    if (atof(tolerance_str) < tolerance) {
+        snprintf(tolerance_str, sizeof(tolerance_str), "%.3g", tolerance * (1 + 5e-3));
+    }
+
+    const char *type = bits == 8 ? "int8_t" : "int16_t";
+    printf("#%s EI_CLASSIFIER_ANOMALY_FIXED_POINT == %d\n\n", bits == 8 ? "if" : "elif", bits);
+    printf("// largest difference between the fixed-point and the float score\n");
+    printf("#define EI_CLASSIFIER_ANOM_FIXED_TOLERANCE    %sf\n\n", tolerance_str);
+
+    print_float_array("ei_classifier_anom_fixed_input_limit", input_limit, n);
+    print_float_array("ei_classifier_anom_fixed_input_mul", input_mul, n);
+    printf("const int32_t ei_classifier_anom_fixed_scaler_mul[] = { ");
+    for (size_t ix = 0; ix < n; ix++) {
+        printf("%s%d", ix ? ", " : "", scaler_mul[ix]);
+    }
+    printf(" };\nconst int64_t ei_classifier_anom_fixed_scaler_add[] = { ");
+    for (size_t ix = 0; ix < n; ix++) {
+        printf("%s%lldLL", ix ? ", " : "", (long long)scaler_add[ix]);
+    }
+    printf(" };\nconst uint8_t ei_classifier_anom_fixed_scaler_shift[] = { ");
+    for (size_t ix = 0; ix < n; ix++) {
+        printf("%s%d", ix ? ", " : "", scaler_shift[ix]);
+    }
+    printf(" };\n\n");
+
+    printf("const %s ei_classifier_anom_fixed_centroids[] = {\n", type);
+    for (size_t cx = 0; cx < k; cx++) {
+        printf("    ");
+        for (size_t ix = 0; ix < n; ix++) {
+            long value = lroundf(clusters[cx].centroid[ix] * one);
+            if (value > limit) {
+                value = limit;
+            }
+            if (value < -limit) {
+                value = -limit;
+            }
+            printf("%ld%s", value, (cx + 1 == k && ix + 1 == n) ? "" : (ix + 1 == n ? "," : ", "));
+        }
+        printf("\n");
+    }
+    printf("};\n");
+    printf("const int32_t ei_classifier_anom_fixed_max_error[] = {\n    ");
+    for (size_t cx = 0; cx < k; cx++) {
+        printf("%ld%s", lroundf(clusters[cx].max_error * one),
+            cx + 1 == k ? "\n" : (cx % 16 == 15 ? ",\n    " : ", "));
+    }
+    printf("};\n\n");
+
+    printf("static_assert(sizeof(ei_classifier_anom_fixed_input_limit) == EI_CLASSIFIER_ANOM_AXIS_SIZE * sizeof(float) &&\n");
+    printf("              sizeof(ei_classifier_anom_fixed_centroids) ==\n");
+    printf("                  EI_CLASSIFIER_ANOM_CLUSTER_COUNT * EI_CLASSIFIER_ANOM_AXIS_SIZE * sizeof(%s) &&\n", type);
+    printf("              sizeof(ei_classifier_anom_fixed_max_error) == EI_CLASSIFIER_ANOM_CLUSTER_COUNT * sizeof(int32_t),\n");
+    printf("              \"anomaly_clusters_fixed.h doesn't match anomaly_clusters.h, run make -C benchmark anomaly_clusters_fixed\");\n\n");
+
+    printf("const ei_classifier_anom_clusters_fixed_t ei_classifier_anom_clusters_fixed = {\n");
+    printf("    EI_CLASSIFIER_ANOM_AXIS_SIZE,\n");
+    printf("    EI_CLASSIFIER_ANOM_CLUSTER_COUNT,\n");
+    printf("    %d, // limit\n", limit);
+    printf("    %d, // frac_bits\n", frac_bits);
+    printf("    ei_classifier_anom_fixed_input_limit,\n");
+    printf("    ei_classifier_anom_fixed_input_mul,\n");
+    printf("    ei_classifier_anom_fixed_scaler_mul,\n");
+    printf("    ei_classifier_anom_fixed_scaler_add,\n");
+    printf("    ei_classifier_anom_fixed_scaler_shift,\n");
+    if (bits == 8) {
+        printf("    ei_classifier_anom_fixed_centroids,\n    NULL,\n");
+    }
+    else {
+        printf("    NULL,\n    ei_classifier_anom_fixed_centroids,\n");
+    }
+    printf("    ei_classifier_anom_fixed_max_error\n};\n\n");
+}
+
+int main() {
+    print_header();
+    print_tables(8);
+    print_tables(16);
+    printf("#endif // EI_CLASSIFIER_ANOMALY_FIXED_POINT\n\n");
+    printf("#endif // _EI_CLASSIFIER_ANOMALY_CLUSTERS_FIXED_H_\n");
+    return 0;
+}
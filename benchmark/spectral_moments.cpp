@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Spectral analysis (v2) statistics: the separate subtract_mean / numpy::rms /
+// skew and kurtosis passes against spectral::processing::subtract_mean_and_sum_powers.
+// Build spectral_moments_vectorized for EIDSP_SPECTRAL_MOMENTS_VECTORIZED=1.
+
+#include "edge-impulse-sdk/dsp/spectral/processing.hpp"
+#include "bench_common.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace ei;
+
+static const int axes = 3;
+
+static void moments_separate(float *data, size_t size, float out[3]) {
+    matrix_t m(1, size, data);
+    spectral::processing::subtract_mean(&m);
+    matrix_t rms_out(1, 1, &out[0]);
+    numpy::rms(&m, &rms_out);
+    float s_sum = 0, k_sum = 0;
+    for (size_t ix = 0; ix < size; ix++) {
+        float t = data[ix] * data[ix] * data[ix];
+        s_sum += t;
+        k_sum += t * data[ix];
+    }
+    out[1] = s_sum;
+    out[2] = k_sum;
+}
+
+static void moments_fused(float *data, size_t size, float out[3]) {
+    float power_sums[3];
+    spectral::processing::subtract_mean_and_sum_powers(data, size, power_sums);
+    out[0] = sqrt(power_sums[0] / static_cast<float>(size));
+    out[1] = power_sums[1];
+    out[2] = power_sums[2];
+}
+
+static void run(size_t size, int reps) {
+    std::vector<float> signal(axes * size), work(axes * size);
+    for (size_t ix = 0; ix < signal.size(); ix++) {
+        signal[ix] = sinf(ix * 0.01f) * 3 + (ix % 7);
+    }
+
+    float sep[axes][3], fused[axes][3];
+    auto bench = [&](void (*fn)(float*, size_t, float*), float (*out)[3]) {
+        return bench_best_ns(reps, [&] {
+            memcpy(work.data(), signal.data(), signal.size() * sizeof(float));
+            for (int axis = 0; axis < axes; axis++) {
+                fn(work.data() + axis * size, size, out[axis]);
+            }
+            bench_sink = out[0][0];
+        });
+    };
+
+    uint64_t sep_ns = bench(moments_separate, sep);
+    uint64_t fused_ns = bench(moments_fused, fused);
+
+    float max_rel = 0;
+    for (int axis = 0; axis < axes; axis++) {
+        for (int ix = 0; ix < 3; ix++) {
+            float rel = fabsf(sep[axis][ix] - fused[axis][ix]) / fmaxf(fabsf(sep[axis][ix]), 1e-20f);
+            max_rel = fmaxf(max_rel, rel);
+        }
+    }
+
+    printf("%d axes x %zu samples (includes a copy of the window)\n", axes, size);
+    bench_print("  separate passes", sep_ns);
+    bench_print("  fused", fused_ns);
+    printf("  max relative difference %g\n", max_rel);
+}
+
+int main() {
+#if EIDSP_SPECTRAL_MOMENTS_VECTORIZED == 1
+    printf("EIDSP_SPECTRAL_MOMENTS_VECTORIZED=1\n");
+#endif
+    run(125, 2000);
+    run(4096, 200);
+    return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Spectral analysis wavelet features (spectral::wavelet::extract_wavelet_features).
+// Build wavelet_features_nocache for EIDSP_WAVELET_WORKSPACE_CACHE=0, which allocates the
+// workspace on every call; the checksum should be the same for both.
+
+#include "model-parameters/model_metadata.h"
+#include "edge-impulse-sdk/dsp/spectral/wavelet.hpp"
+#include "bench_common.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace ei;
+
+static void run(const char *wav, int level, size_t frames, int reps) {
+    const size_t axes = 3;
+
+    ei_dsp_config_spectral_analysis_t config = { };
+    config.implementation_version = 2;
+    config.axes = axes;
+    config.scale_axes = 1.0f;
+    config.filter_type = "none";
+    config.analysis_type = "Wavelet";
+    config.wavelet_level = level;
+    config.wavelet = wav;
+
+    std::vector<float> signal(frames * axes), work(frames * axes);
+    for (size_t ix = 0; ix < signal.size(); ix++) {
+        signal[ix] = sinf(ix * 0.37f) * 3 + cosf(ix * 0.011f) + (ix % 7) * 0.1f;
+    }
+
+    const size_t feature_count = axes * (level + 1) * spectral::wavelet::NUM_FEATHERS_PER_COMP;
+    std::vector<float> features(feature_count);
+    int ret = EIDSP_OK;
+
+    uint64_t ns = bench_best_ns(reps, [&] {
+        memcpy(work.data(), signal.data(), signal.size() * sizeof(float));
+        matrix_t input_matrix(frames, axes, work.data());
+        matrix_t output_matrix(1, feature_count, features.data());
+        ret |= spectral::wavelet::extract_wavelet_features(&input_matrix, &output_matrix, &config, 62.5f);
+        bench_sink = features[0];
+    });
+
+    double checksum = 0;
+    for (float f : features) {
+        checksum += f;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s level %d, %zu axes x %zu", wav, level, axes, frames);
+    bench_print(name, ns);
+    printf("  ret %d, checksum %.9g\n", ret, checksum);
+}
+
+int main() {
+#if EIDSP_WAVELET_WORKSPACE_CACHE == 0
+    printf("EIDSP_WAVELET_WORKSPACE_CACHE=0\n");
+#endif
+    run("db4", 1, 125, 20000);
+    run("db4", 4, 1000, 2000);
+    run("bior3.5", 3, 500, 2000);
+    return 0;
+}
@@ -21,12 +21,107 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdint.h>
+#include <float.h>
 #include "model-parameters/anomaly_types.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// number of clusters get_min_distance_to_cluster_soa scores at once (one per SIMD lane)
+#define EI_CLASSIFIER_ANOM_SOA_BLOCK        8
+// clusters per row in ei_classifier_anom_clusters_soa_t, cluster count rounded up to a full block
+#define EI_CLASSIFIER_ANOM_SOA_STRIDE(cluster_count) \
+    ((((cluster_count) + EI_CLASSIFIER_ANOM_SOA_BLOCK - 1) / EI_CLASSIFIER_ANOM_SOA_BLOCK) * EI_CLASSIFIER_ANOM_SOA_BLOCK)
+
+// floats needed for the centroids, max errors and norms of ei_classifier_anom_clusters_soa_t
+#define EI_CLASSIFIER_ANOM_SOA_SIZE(input_size, cluster_count) \
+    (((input_size) + 2) * EI_CLASSIFIER_ANOM_SOA_STRIDE(cluster_count))
+
+// number of inputs get_min_distance_to_cluster_batch scores against a block of clusters at once
+#define EI_CLASSIFIER_ANOM_BATCH_ROWS       4
+
+/**
+ * Centroids in structure-of-arrays layout: one row per input axis, with that axis of every
+ * cluster next to each other, so the distances to a block of clusters are calculated in SIMD lanes.
+ */
+typedef struct {
+    size_t input_size;
+    size_t cluster_count;
+    size_t cluster_stride; // EI_CLASSIFIER_ANOM_SOA_STRIDE(cluster_count)
+    const float *centroids; // input_size x cluster_stride
+    const float *max_error; // cluster_stride, -FLT_MAX for the padding clusters
+    const float *norm; // cluster_stride, squared length of every centroid
+    const ei_classifier_anom_cluster_t *clusters; // original clusters, for the exact distance
+} ei_classifier_anom_clusters_soa_t;
+
+// most clusters in a leaf of ei_classifier_anom_tree_t (nodes are split at the median, so
+// a leaf holds at least half of this)
+#define EI_CLASSIFIER_ANOM_TREE_LEAF_SIZE   8
+// upper bound on the number of nodes in ei_classifier_anom_tree_t
+#define EI_CLASSIFIER_ANOM_TREE_MAX_NODES(cluster_count) \
+    (2 * (((cluster_count) + (EI_CLASSIFIER_ANOM_TREE_LEAF_SIZE / 2) - 1) / (EI_CLASSIFIER_ANOM_TREE_LEAF_SIZE / 2)) + 1)
+
+/**
+ * Node of ei_classifier_anom_tree_t, a ball around the centroids of the clusters in
+ * index[start..end)
+ */
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+    int32_t left; // child nodes, -1 for a leaf
+    int32_t right;
+    float radius; // distance from the center (in centers) to the farthest centroid, rounded up
+    float max_error; // highest max_error of the clusters in the node
+} ei_classifier_anom_tree_node_t;
+
+/**
+ * Ball tree over the cluster centroids. The score of a cluster is its distance minus its
+ * max_error, so for a node no cluster scores below |input - center| - radius - max_error,
+ * and nodes that can't beat the best score so far are skipped.
+ */
+typedef struct {
+    size_t input_size;
+    size_t node_count;
+    ei_classifier_anom_tree_node_t *nodes; // nodes[0] is the root
+    float *centers; // input_size floats per node
+    uint32_t *index; // cluster indices, ordered so every node is a contiguous range
+    const ei_classifier_anom_cluster_t *clusters;
+} ei_classifier_anom_tree_t;
+
+/**
+ * Clusters in fixed point, for targets without an FPU. Scaled features and centroids are
+ * stored as value * 2^frac_bits, rounded, in int8 or int16. frac_bits is picked so twice the
+ * largest centroid still fits, scaled features further out than that saturate.
+ * The standard scaler is integer math too: an input is clamped to +-input_limit (past which
+ * the scaled feature saturates anyway), turned into an integer as input * input_mul, and
+ * scaled as (value * scaler_mul + scaler_add) >> scaler_shift, rounded.
+ * Generated from the float clusters by benchmark/gen_anomaly_clusters_fixed.cpp, see
+ * model-parameters/anomaly_clusters_fixed.h.
+ */
+typedef struct {
+    size_t input_size;
+    size_t cluster_count;
+    int32_t limit; // largest magnitude of a fixed-point value (127 or 32767)
+    int frac_bits;
+    const float *input_limit; // input_size
+    const float *input_mul; // input_size, powers of 2, input_limit * input_mul < 2^30
+    const int32_t *scaler_mul; // input_size, 2^frac_bits / scale / input_mul * 2^scaler_shift
+    const int64_t *scaler_add; // input_size, -mean * 2^frac_bits / scale * 2^scaler_shift
+    const uint8_t *scaler_shift; // input_size
+    const int8_t *centroids8; // cluster_count x input_size for int8 clusters, otherwise NULL
+    const int16_t *centroids16; // cluster_count x input_size for int16 clusters, otherwise NULL
+    const int32_t *max_error; // cluster_count, in fixed point
+} ei_classifier_anom_clusters_fixed_t;
 
 #ifdef __cplusplus
 namespace {
 #endif // __cplusplus
 
+#if EI_CLASSIFIER_ANOMALY_FIXED_POINT == 0
 /**
  * Standard scaler, scales all values in the input vector
  * Note that this *modifies* the array in place!
@@ -57,6 +152,7 @@ float calculate_cluster_distance(float *input, size_t input_size, const ei_class
     return sqrt(dist) - cluster->max_error;
 }
 
+#if EI_CLASSIFIER_ANOMALY_SOA != 1 && EI_CLASSIFIER_ANOMALY_TREE != 1
 /**
  * Get minimum distance to a cluster
  * @param input Array of input values (already scaled by standard_scaler)
@@ -74,6 +170,618 @@ float get_min_distance_to_cluster(float *input, size_t input_size, const ei_clas
     }
     return min;
 }
+#endif // EI_CLASSIFIER_ANOMALY_SOA != 1 && EI_CLASSIFIER_ANOMALY_TREE != 1
+
+/**
+ * Set up the structure-of-arrays layout of a cluster array
+ * @param soa Out
+ * @param clusters Array of clusters, needs to stay alive while soa is used
+ * @param cluster_size Size of cluster array
+ * @param input_size Size of the input array (number of centroids per cluster)
+ * @param buffer EI_CLASSIFIER_ANOM_SOA_SIZE(input_size, cluster_size) floats
+ */
+void init_clusters_soa(
+    ei_classifier_anom_clusters_soa_t *soa,
+    const ei_classifier_anom_cluster_t *clusters,
+    size_t cluster_size,
+    size_t input_size,
+    float *buffer)
+{
+    const size_t stride = EI_CLASSIFIER_ANOM_SOA_STRIDE(cluster_size);
+
+    for (size_t ix = 0; ix < input_size; ix++) {
+        float *row = buffer + (ix * stride);
+        for (size_t cx = 0; cx < stride; cx++) {
+            row[cx] = cx < cluster_size ? clusters[cx].centroid[ix] : 0.0f;
+        }
+    }
+
+    // padding clusters can never lower the score
+    float *max_error = buffer + (input_size * stride);
+    for (size_t cx = 0; cx < stride; cx++) {
+        max_error[cx] = cx < cluster_size ? clusters[cx].max_error : -FLT_MAX;
+    }
+
+    float *norm = max_error + stride;
+    for (size_t cx = 0; cx < stride; cx++) {
+        norm[cx] = 0.0f;
+    }
+    for (size_t ix = 0; ix < input_size; ix++) {
+        const float *row = buffer + (ix * stride);
+        for (size_t cx = 0; cx < stride; cx++) {
+            norm[cx] += row[cx] * row[cx];
+        }
+    }
+
+    soa->input_size = input_size;
+    soa->cluster_count = cluster_size;
+    soa->cluster_stride = stride;
+    soa->centroids = buffer;
+    soa->max_error = max_error;
+    soa->norm = norm;
+    soa->clusters = clusters;
+}
+
+#if EI_CLASSIFIER_ANOMALY_SOA == 1 && EI_CLASSIFIER_ANOMALY_TREE != 1 && EI_CLASSIFIER_ANOMALY_FIXED_POINT == 0
+/**
+ * Get minimum distance to a cluster, same result as get_min_distance_to_cluster.
+ * The squared distances to every cluster are calculated in blocks, in float. A cluster can
+ * only lower the minimum if sqrt(dist) < min + max_error, which is checked on the squared
+ * distance (with a margin for rounding), so only those clusters go through
+ * calculate_cluster_distance (and its sqrt) to get the exact same score.
+ * @param input Array of input values (already scaled by standard_scaler)
+ * @param soa Clusters, see init_clusters_soa
+ */
+float get_min_distance_to_cluster_soa(const float *input, const ei_classifier_anom_clusters_soa_t *soa) {
+    const size_t input_size = soa->input_size;
+    const size_t stride = soa->cluster_stride;
+    // rounding of the float sums (and of sqrt) here and in calculate_cluster_distance
+    const float margin = 1.0f + (4.0f * input_size + 16.0f) * FLT_EPSILON;
+
+    float min = 1000.0f;
+    for (size_t block = 0; block < stride; block += EI_CLASSIFIER_ANOM_SOA_BLOCK) {
+        float dist[EI_CLASSIFIER_ANOM_SOA_BLOCK] = { 0 };
+
+        const float *centroids = soa->centroids + block;
+        for (size_t ix = 0; ix < input_size; ix++) {
+            const float value = input[ix];
+            for (size_t lane = 0; lane < EI_CLASSIFIER_ANOM_SOA_BLOCK; lane++) {
+                float diff = value - centroids[lane];
+                dist[lane] += diff * diff;
+            }
+            centroids += stride;
+        }
+
+        // sqrt(dist) - max_error < min needs sqrt(dist) < min + max_error
+        const float *max_error = soa->max_error + block;
+        int candidate[EI_CLASSIFIER_ANOM_SOA_BLOCK];
+        int any_candidate = 0;
+        for (size_t lane = 0; lane < EI_CLASSIFIER_ANOM_SOA_BLOCK; lane++) {
+            float bound = min + max_error[lane];
+            candidate[lane] = (bound > 0.0f) & (dist[lane] <= bound * bound * margin);
+            any_candidate |= candidate[lane];
+        }
+        if (!any_candidate) {
+            continue;
+        }
+
+        for (size_t lane = 0; lane < EI_CLASSIFIER_ANOM_SOA_BLOCK; lane++) {
+            if (!candidate[lane]) {
+                continue;
+            }
+            float cluster_dist = calculate_cluster_distance(
+                (float *)input, input_size, &soa->clusters[block + lane]);
+            if (cluster_dist < min) {
+                min = cluster_dist;
+            }
+        }
+    }
+    return min;
+}
+#endif // EI_CLASSIFIER_ANOMALY_SOA
+
+/**
+ * Dot products of EI_CLASSIFIER_ANOM_BATCH_ROWS (4) inputs with a block of
+ * EI_CLASSIFIER_ANOM_SOA_BLOCK (8) centroids, kept in registers (SSE2 or NEON, plain C otherwise)
+ * @param input Inputs
+ * @param input_size Size of every input
+ * @param centroids First centroid of the block in the structure-of-arrays layout
+ * @param stride Row stride of centroids
+ * @param dot Out
+ */
+void anom_batch_dot(
+    const float **input,
+    size_t input_size,
+    const float *centroids,
+    size_t stride,
+    float dot[EI_CLASSIFIER_ANOM_BATCH_ROWS][EI_CLASSIFIER_ANOM_SOA_BLOCK])
+{
+#if defined(__SSE2__) || defined(_M_X64)
+    __m128 dot00 = _mm_setzero_ps(), dot01 = _mm_setzero_ps();
+    __m128 dot10 = _mm_setzero_ps(), dot11 = _mm_setzero_ps();
+    __m128 dot20 = _mm_setzero_ps(), dot21 = _mm_setzero_ps();
+    __m128 dot30 = _mm_setzero_ps(), dot31 = _mm_setzero_ps();
+    for (size_t ix = 0; ix < input_size; ix++) {
+        const __m128 c0 = _mm_loadu_ps(centroids);
+        const __m128 c1 = _mm_loadu_ps(centroids + 4);
+        __m128 value = _mm_set1_ps(input[0][ix]);
+        dot00 = _mm_add_ps(dot00, _mm_mul_ps(value, c0));
+        dot01 = _mm_add_ps(dot01, _mm_mul_ps(value, c1));
+        value = _mm_set1_ps(input[1][ix]);
+        dot10 = _mm_add_ps(dot10, _mm_mul_ps(value, c0));
+        dot11 = _mm_add_ps(dot11, _mm_mul_ps(value, c1));
+        value = _mm_set1_ps(input[2][ix]);
+        dot20 = _mm_add_ps(dot20, _mm_mul_ps(value, c0));
+        dot21 = _mm_add_ps(dot21, _mm_mul_ps(value, c1));
+        value = _mm_set1_ps(input[3][ix]);
+        dot30 = _mm_add_ps(dot30, _mm_mul_ps(value, c0));
+        dot31 = _mm_add_ps(dot31, _mm_mul_ps(value, c1));
+        centroids += stride;
+    }
+    _mm_storeu_ps(dot[0], dot00); _mm_storeu_ps(dot[0] + 4, dot01);
+    _mm_storeu_ps(dot[1], dot10); _mm_storeu_ps(dot[1] + 4, dot11);
+    _mm_storeu_ps(dot[2], dot20); _mm_storeu_ps(dot[2] + 4, dot21);
+    _mm_storeu_ps(dot[3], dot30); _mm_storeu_ps(dot[3] + 4, dot31);
+#elif defined(__ARM_NEON)
+    float32x4_t dot00 = vdupq_n_f32(0.0f), dot01 = vdupq_n_f32(0.0f);
+    float32x4_t dot10 = vdupq_n_f32(0.0f), dot11 = vdupq_n_f32(0.0f);
+    float32x4_t dot20 = vdupq_n_f32(0.0f), dot21 = vdupq_n_f32(0.0f);
+    float32x4_t dot30 = vdupq_n_f32(0.0f), dot31 = vdupq_n_f32(0.0f);
+    for (size_t ix = 0; ix < input_size; ix++) {
+        const float32x4_t c0 = vld1q_f32(centroids);
+        const float32x4_t c1 = vld1q_f32(centroids + 4);
+        dot00 = vmlaq_n_f32(dot00, c0, input[0][ix]);
+        dot01 = vmlaq_n_f32(dot01, c1, input[0][ix]);
+        dot10 = vmlaq_n_f32(dot10, c0, input[1][ix]);
+        dot11 = vmlaq_n_f32(dot11, c1, input[1][ix]);
+        dot20 = vmlaq_n_f32(dot20, c0, input[2][ix]);
+        dot21 = vmlaq_n_f32(dot21, c1, input[2][ix]);
+        dot30 = vmlaq_n_f32(dot30, c0, input[3][ix]);
+        dot31 = vmlaq_n_f32(dot31, c1, input[3][ix]);
+        centroids += stride;
+    }
+    vst1q_f32(dot[0], dot00); vst1q_f32(dot[0] + 4, dot01);
+    vst1q_f32(dot[1], dot10); vst1q_f32(dot[1] + 4, dot11);
+    vst1q_f32(dot[2], dot20); vst1q_f32(dot[2] + 4, dot21);
+    vst1q_f32(dot[3], dot30); vst1q_f32(dot[3] + 4, dot31);
+#else
+    for (size_t row = 0; row < EI_CLASSIFIER_ANOM_BATCH_ROWS; row++) {
+        for (size_t lane = 0; lane < EI_CLASSIFIER_ANOM_SOA_BLOCK; lane++) {
+            dot[row][lane] = 0.0f;
+        }
+    }
+    for (size_t ix = 0; ix < input_size; ix++) {
+        for (size_t row = 0; row < EI_CLASSIFIER_ANOM_BATCH_ROWS; row++) {
+            const float value = input[row][ix];
+            for (size_t lane = 0; lane < EI_CLASSIFIER_ANOM_SOA_BLOCK; lane++) {
+                dot[row][lane] += value * centroids[lane];
+            }
+        }
+        centroids += stride;
+    }
+#endif
+}
+
+/**
+ * Get minimum distance to a cluster for a batch of inputs, same results as
+ * get_min_distance_to_cluster on every input.
+ * The squared distances are calculated as |x|^2 + |c|^2 - 2 x.c, so the distances between
+ * EI_CLASSIFIER_ANOM_BATCH_ROWS inputs and a block of clusters are a small matrix product,
+ * and every block of centroids is loaded once for all of those inputs. That form cancels,
+ * so the margin grows with |x|^2 + |c|^2; clusters that pass go through
+ * calculate_cluster_distance to get the exact same score.
+ * @param inputs input_count rows of soa->input_size values (already scaled by standard_scaler)
+ * @param input_count Number of inputs
+ * @param soa Clusters, see init_clusters_soa
+ * @param output Out, input_count scores
+ */
+void get_min_distance_to_cluster_batch(
+    const float *inputs,
+    size_t input_count,
+    const ei_classifier_anom_clusters_soa_t *soa,
+    float *output)
+{
+    const size_t input_size = soa->input_size;
+    const size_t stride = soa->cluster_stride;
+    // rounding of the float sums (and of sqrt) here and in calculate_cluster_distance
+    const float tolerance = (4.0f * input_size + 16.0f) * FLT_EPSILON;
+    const float margin = 1.0f + tolerance;
+
+    for (size_t row_start = 0; row_start < input_count; row_start += EI_CLASSIFIER_ANOM_BATCH_ROWS) {
+        size_t rows = input_count - row_start;
+        if (rows > EI_CLASSIFIER_ANOM_BATCH_ROWS) {
+            rows = EI_CLASSIFIER_ANOM_BATCH_ROWS;
+        }
+        // a short last block repeats its first input, so the kernel always has full blocks
+        const float *input[EI_CLASSIFIER_ANOM_BATCH_ROWS];
+        float input_norm[EI_CLASSIFIER_ANOM_BATCH_ROWS];
+        float min[EI_CLASSIFIER_ANOM_BATCH_ROWS];
+        for (size_t row = 0; row < EI_CLASSIFIER_ANOM_BATCH_ROWS; row++) {
+            input[row] = inputs + ((row_start + (row < rows ? row : 0)) * input_size);
+            input_norm[row] = 0.0f;
+            for (size_t ix = 0; ix < input_size; ix++) {
+                input_norm[row] += input[row][ix] * input[row][ix];
+            }
+            min[row] = 1000.0f;
+        }
+
+        for (size_t block = 0; block < stride; block += EI_CLASSIFIER_ANOM_SOA_BLOCK) {
+            float dot[EI_CLASSIFIER_ANOM_BATCH_ROWS][EI_CLASSIFIER_ANOM_SOA_BLOCK];
+            anom_batch_dot(input, input_size, soa->centroids + block, stride, dot);
+
+            // sqrt(dist) - max_error < min needs sqrt(dist) < min + max_error
+            const float *max_error = soa->max_error + block;
+            const float *norm = soa->norm + block;
+            for (size_t row = 0; row < rows; row++) {
+                int candidate[EI_CLASSIFIER_ANOM_SOA_BLOCK];
+                int any_candidate = 0;
+                for (size_t lane = 0; lane < EI_CLASSIFIER_ANOM_SOA_BLOCK; lane++) {
+                    float bound = min[row] + max_error[lane];
+                    float norms = input_norm[row] + norm[lane];
+                    float dist = norms - 2.0f * dot[row][lane] - tolerance * norms;
+                    candidate[lane] = (bound > 0.0f) & (dist <= bound * bound * margin);
+                    any_candidate |= candidate[lane];
+                }
+                if (!any_candidate) {
+                    continue;
+                }
+
+                for (size_t lane = 0; lane < EI_CLASSIFIER_ANOM_SOA_BLOCK; lane++) {
+                    if (!candidate[lane]) {
+                        continue;
+                    }
+                    float cluster_dist = calculate_cluster_distance(
+                        (float *)input[row], input_size, &soa->clusters[block + lane]);
+                    if (cluster_dist < min[row]) {
+                        min[row] = cluster_dist;
+                    }
+                }
+            }
+        }
+
+        for (size_t row = 0; row < rows; row++) {
+            output[row_start + row] = min[row];
+        }
+    }
+}
+#endif // EI_CLASSIFIER_ANOMALY_FIXED_POINT == 0
+
+#if EI_CLASSIFIER_ANOMALY_TREE == 1 && EI_CLASSIFIER_ANOMALY_FIXED_POINT == 0
+/**
+ * Reorder index[start..end) so index[nth] holds the cluster with the nth smallest centroid[axis],
+ * with smaller ones before it and larger ones after it
+ */
+void anom_tree_select(
+    uint32_t *index,
+    size_t start,
+    size_t end,
+    size_t nth,
+    const ei_classifier_anom_cluster_t *clusters,
+    size_t axis)
+{
+    while (end - start > 1) {
+        const float pivot = clusters[index[start + (end - start) / 2]].centroid[axis];
+
+        // three-way partition, so runs of equal values don't degrade
+        size_t lt = start, ix = start, gt = end;
+        while (ix < gt) {
+            float value = clusters[index[ix]].centroid[axis];
+            if (value < pivot) {
+                uint32_t tmp = index[lt]; index[lt] = index[ix]; index[ix] = tmp;
+                lt++;
+                ix++;
+            }
+            else if (value > pivot) {
+                gt--;
+                uint32_t tmp = index[gt]; index[gt] = index[ix]; index[ix] = tmp;
+            }
+            else {
+                ix++;
+            }
+        }
+
+        if (nth < lt) {
+            end = lt;
+        }
+        else if (nth >= gt) {
+            start = gt;
+        }
+        else {
+            return;
+        }
+    }
+}
+
+/**
+ * Build the subtree over index[start..end)
+ * @returns Node index
+ */
+int32_t anom_tree_build_node(ei_classifier_anom_tree_t *tree, size_t start, size_t end)
+{
+    const size_t input_size = tree->input_size;
+    const ei_classifier_anom_cluster_t *clusters = tree->clusters;
+    const int32_t node_ix = (int32_t)tree->node_count++;
+    ei_classifier_anom_tree_node_t *node = &tree->nodes[node_ix];
+    float *center = tree->centers + (node_ix * input_size);
+
+    // center of the bounding box, split along its widest axis
+    size_t split_axis = 0;
+    float split_width = -1.0f;
+    for (size_t ax = 0; ax < input_size; ax++) {
+        float lo = clusters[tree->index[start]].centroid[ax];
+        float hi = lo;
+        for (size_t ix = start + 1; ix < end; ix++) {
+            float value = clusters[tree->index[ix]].centroid[ax];
+            if (value < lo) lo = value;
+            if (value > hi) hi = value;
+        }
+        center[ax] = lo + (hi - lo) / 2.0f;
+        if (hi - lo > split_width) {
+            split_width = hi - lo;
+            split_axis = ax;
+        }
+    }
+
+    double radius = 0.0;
+    float max_error = -FLT_MAX;
+    for (size_t ix = start; ix < end; ix++) {
+        const ei_classifier_anom_cluster_t *cluster = &clusters[tree->index[ix]];
+        double dist = 0.0;
+        for (size_t ax = 0; ax < input_size; ax++) {
+            double diff = (double)cluster->centroid[ax] - center[ax];
+            dist += diff * diff;
+        }
+        if (dist > radius) {
+            radius = dist;
+        }
+        if (cluster->max_error > max_error) {
+            max_error = cluster->max_error;
+        }
+    }
+
+    node->start = (uint32_t)start;
+    node->end = (uint32_t)end;
+    node->radius = (float)(sqrt(radius) * (1.0 + 4.0 * FLT_EPSILON));
+    node->max_error = max_error;
+    node->left = -1;
+    node->right = -1;
+
+    if (end - start > EI_CLASSIFIER_ANOM_TREE_LEAF_SIZE) {
+        size_t mid = start + (end - start) / 2;
+        anom_tree_select(tree->index, start, end, mid, clusters, split_axis);
+        node->left = anom_tree_build_node(tree, start, mid);
+        node->right = anom_tree_build_node(tree, mid, end);
+    }
+    return node_ix;
+}
+
+/**
+ * Build a ball tree over a cluster array
+ * @param tree Out
+ * @param clusters Array of clusters, needs to stay alive while tree is used
+ * @param cluster_size Size of cluster array (> 0)
+ * @param input_size Size of the input array (number of centroids per cluster)
+ * @param nodes EI_CLASSIFIER_ANOM_TREE_MAX_NODES(cluster_size) nodes
+ * @param centers input_size * EI_CLASSIFIER_ANOM_TREE_MAX_NODES(cluster_size) floats
+ * @param index cluster_size indices
+ */
+void init_clusters_tree(
+    ei_classifier_anom_tree_t *tree,
+    const ei_classifier_anom_cluster_t *clusters,
+    size_t cluster_size,
+    size_t input_size,
+    ei_classifier_anom_tree_node_t *nodes,
+    float *centers,
+    uint32_t *index)
+{
+    for (size_t ix = 0; ix < cluster_size; ix++) {
+        index[ix] = (uint32_t)ix;
+    }
+
+    tree->input_size = input_size;
+    tree->node_count = 0;
+    tree->nodes = nodes;
+    tree->centers = centers;
+    tree->index = index;
+    tree->clusters = clusters;
+
+    anom_tree_build_node(tree, 0, cluster_size);
+}
+
+/**
+ * Lowest score any cluster in a node can have (minus a margin for rounding in
+ * calculate_cluster_distance)
+ */
+double anom_tree_node_bound(const ei_classifier_anom_tree_t *tree, int32_t node_ix, const float *input)
+{
+    const ei_classifier_anom_tree_node_t *node = &tree->nodes[node_ix];
+    const float *center = tree->centers + (node_ix * tree->input_size);
+
+    double dist = 0.0;
+    for (size_t ax = 0; ax < tree->input_size; ax++) {
+        double diff = (double)input[ax] - center[ax];
+        dist += diff * diff;
+    }
+    dist = sqrt(dist);
+
+    double margin = (4.0 * tree->input_size + 16.0) * FLT_EPSILON *
+        (dist + node->radius + fabs(node->max_error));
+    return dist - node->radius - node->max_error - margin;
+}
+
+/**
+ * Get minimum distance to a cluster, same result as get_min_distance_to_cluster, but only
+ * visits the parts of the tree that can still lower the score (nearest node first)
+ * @param input Array of input values (already scaled by standard_scaler)
+ * @param tree Clusters, see init_clusters_tree
+ */
+float get_min_distance_to_cluster_tree(const float *input, const ei_classifier_anom_tree_t *tree) {
+    // a path down the tree, and one sibling per level
+    int32_t stack[64];
+    double stack_bound[64];
+    size_t stack_size = 0;
+
+    float min = 1000.0f;
+
+    stack[0] = 0;
+    stack_bound[0] = anom_tree_node_bound(tree, 0, input);
+    stack_size = 1;
+
+    while (stack_size > 0) {
+        stack_size--;
+        const int32_t node_ix = stack[stack_size];
+        // min might have gone down since the node was pushed
+        if (stack_bound[stack_size] >= min) {
+            continue;
+        }
+
+        const ei_classifier_anom_tree_node_t *node = &tree->nodes[node_ix];
+        if (node->left < 0) {
+            for (uint32_t ix = node->start; ix < node->end; ix++) {
+                float dist = calculate_cluster_distance(
+                    (float *)input, tree->input_size, &tree->clusters[tree->index[ix]]);
+                if (dist < min) {
+                    min = dist;
+                }
+            }
+            continue;
+        }
+
+        double left_bound = anom_tree_node_bound(tree, node->left, input);
+        double right_bound = anom_tree_node_bound(tree, node->right, input);
+
+        // push the farther child first, so the nearer one is visited first
+        if (left_bound < right_bound) {
+            stack[stack_size] = node->right; stack_bound[stack_size] = right_bound; stack_size++;
+            stack[stack_size] = node->left; stack_bound[stack_size] = left_bound; stack_size++;
+        }
+        else {
+            stack[stack_size] = node->left; stack_bound[stack_size] = left_bound; stack_size++;
+            stack[stack_size] = node->right; stack_bound[stack_size] = right_bound; stack_size++;
+        }
+    }
+    return min;
+}
+#endif // EI_CLASSIFIER_ANOMALY_TREE
+
+#if EI_CLASSIFIER_ANOMALY_FIXED_POINT != 0
+/**
+ * Standard scaler into fixed point, (input - mean) / scale in integer math, rounded and
+ * saturated to the range of the clusters. The only float math is clamping the input and
+ * turning it into an integer.
+ * @param input Array of input values
+ * @param fixed Clusters, see ei_classifier_anom_clusters_fixed_t
+ * @param output Out, fixed->input_size values
+ */
+void standard_scaler_fixed(const float *input, const ei_classifier_anom_clusters_fixed_t *fixed, int16_t *output) {
+    const int64_t limit = fixed->limit;
+    for (size_t ix = 0; ix < fixed->input_size; ix++) {
+        float value = input[ix];
+        if (value > fixed->input_limit[ix]) {
+            value = fixed->input_limit[ix];
+        }
+        else if (value < -fixed->input_limit[ix]) {
+            value = -fixed->input_limit[ix];
+        }
+        // |value_fixed| < 2^30 and |scaler_mul| < 2^31, so the sum fits in 64 bits
+        const int64_t value_fixed = (int32_t)(value * fixed->input_mul[ix]);
+        const int shift = fixed->scaler_shift[ix];
+        int64_t scaled = (value_fixed * fixed->scaler_mul[ix] + fixed->scaler_add[ix] +
+            ((int64_t)1 << (shift - 1))) >> shift;
+        if (scaled > limit) {
+            scaled = limit;
+        }
+        else if (scaled < -limit) {
+            scaled = -limit;
+        }
+        output[ix] = (int16_t)scaled;
+    }
+}
+
+/**
+ * Square root, rounded to the nearest integer
+ */
+uint32_t anom_isqrt(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    uint64_t rest = value;
+    while (bit != 0) {
+        if (rest >= root + bit) {
+            rest -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    // rest = value - root^2, round up if value > (root + 0.5)^2
+    if (rest > root) {
+        root++;
+    }
+    return (uint32_t)root;
+}
+
+/**
+ * Get minimum distance to a cluster in fixed point, matches get_min_distance_to_cluster
+ * within EI_CLASSIFIER_ANOM_FIXED_TOLERANCE (see model-parameters/anomaly_clusters_fixed.h).
+ * Only integer math, besides turning the score back into a float.
+ * The square root is only taken for clusters that can lower the score.
+ * @param input Array of input values (scaled by standard_scaler_fixed)
+ * @param fixed Clusters, see ei_classifier_anom_clusters_fixed_t
+ */
+float get_min_distance_to_cluster_fixed(const int16_t *input, const ei_classifier_anom_clusters_fixed_t *fixed) {
+    const size_t input_size = fixed->input_size;
+
+    int64_t min = INT64_MAX;
+    for (size_t cx = 0; cx < fixed->cluster_count; cx++) {
+        uint64_t dist = 0;
+        if (fixed->centroids8) {
+            // |diff| <= 254, so the sum fits in 32 bits
+            const int8_t *centroid = fixed->centroids8 + (cx * input_size);
+            uint32_t dist32 = 0;
+            for (size_t ix = 0; ix < input_size; ix++) {
+                int32_t diff = (int32_t)input[ix] - centroid[ix];
+                dist32 += (uint32_t)(diff * diff);
+            }
+            dist = dist32;
+        }
+        else {
+            const int16_t *centroid = fixed->centroids16 + (cx * input_size);
+            for (size_t ix = 0; ix < input_size; ix++) {
+                int32_t diff = (int32_t)input[ix] - centroid[ix];
+                dist += (uint32_t)diff * (uint32_t)diff;
+            }
+        }
+
+        // sqrt(dist) - max_error < min needs sqrt(dist) < min + max_error
+        const int64_t max_error = fixed->max_error[cx];
+        if (min != INT64_MAX) {
+            int64_t bound = min + max_error;
+            if (bound <= 0) {
+                continue;
+            }
+            if (bound <= INT32_MAX && dist >= (uint64_t)(bound * bound)) {
+                continue;
+            }
+        }
+
+        int64_t cluster_dist = (int64_t)anom_isqrt(dist) - max_error;
+        if (cluster_dist < min) {
+            min = cluster_dist;
+        }
+    }
+
+    if (min == INT64_MAX) {
+        return 1000.0f;
+    }
+    float score = (float)min / (float)(1 << fixed->frac_bits);
+    return score < 1000.0f ? score : 1000.0f;
+}
+#endif // EI_CLASSIFIER_ANOMALY_FIXED_POINT != 0
 
 #ifdef __cplusplus
 }
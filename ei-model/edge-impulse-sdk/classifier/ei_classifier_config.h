@@ -69,6 +69,80 @@
     #endif // ESP32 check
 #endif
 
+// Run the int8 fully connected layers of the reference (non CMSIS-NN / ARC / ESP-NN / MVP)
+// TFLite Micro kernels with SIMD kernels: AVX2 when building with -mavx2, SSE2 on other
+// x86-64 targets, NEON on Arm. Same outputs as the reference kernel. Layers with per-channel
+// quantized weights always use these kernels, as the reference kernel is per-tensor only.
+#ifndef EI_CLASSIFIER_TFLITE_ENABLE_SIMD_FULLY_CONNECTED
+#if defined(__SSE2__) || defined(_M_X64) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define EI_CLASSIFIER_TFLITE_ENABLE_SIMD_FULLY_CONNECTED    1
+#else
+#define EI_CLASSIFIER_TFLITE_ENABLE_SIMD_FULLY_CONNECTED    0
+#endif
+#endif // EI_CLASSIFIER_TFLITE_ENABLE_SIMD_FULLY_CONNECTED
+
+// Number of windows run_classifier_batch() runs through DSP before running the model
+// over them, the features for all of these are kept in memory at once.
+#ifndef EI_CLASSIFIER_BATCH_SIZE
+#define EI_CLASSIFIER_BATCH_SIZE                    16
+#endif // EI_CLASSIFIER_BATCH_SIZE
+
+// Enable ClassifierBatchPool (ei_run_classifier.h), which runs batches of windows on
+// several threads. Needs std::thread, so only for Linux / POSIX hosts.
+#ifndef EI_CLASSIFIER_ENABLE_THREAD_POOL
+#define EI_CLASSIFIER_ENABLE_THREAD_POOL            0
+#endif // EI_CLASSIFIER_ENABLE_THREAD_POOL
+
+// Keep the model (EON arena or TFLite interpreter) alive between inference calls,
+// instead of setting it up and tearing it down on every call. This trades the
+// arena being allocated at all times for lower steady-state latency.
+// Call run_classifier_deinit() to release the model.
+#ifndef EI_CLASSIFIER_PERSISTENT_SESSION
+#define EI_CLASSIFIER_PERSISTENT_SESSION            0
+#endif // EI_CLASSIFIER_PERSISTENT_SESSION
+
+// Run DSP blocks through extract functions that are specialized (templated) on the shape
+// of their config, rather than the generic ones that parse the config at runtime. The
+// shape is in model-parameters/dsp_config_static.h: axes and frames come from the generated
+// headers, the rest is maintained by hand and checked against model_variables.h at runtime
+// (a mismatch fails with EIDSP_PARAMETER_INVALID). The specialized functions are wired into
+// dsp_blocks.h by hand, so redo that when the model is exported again. Buffers are fixed size and on the stack, so this needs a few KB
+// more stack during DSP. Only supported for spectral analysis (v1, FFT) blocks for now.
+#ifndef EI_CLASSIFIER_DSP_SPECIALIZED
+#define EI_CLASSIFIER_DSP_SPECIALIZED               0
+#endif // EI_CLASSIFIER_DSP_SPECIALIZED
+
+// Score the K-means anomaly block against a structure-of-arrays copy of the cluster centroids,
+// which is built in RAM on first use (axes x clusters floats). Distances to 8 clusters are
+// calculated at once and sqrt is only taken for clusters that can lower the score. Same score
+// as the default path. run_classifier_batch() scores against this copy either way.
+#ifndef EI_CLASSIFIER_ANOMALY_SOA
+#define EI_CLASSIFIER_ANOMALY_SOA                   0
+#endif // EI_CLASSIFIER_ANOMALY_SOA
+
+// Score the K-means anomaly block with a ball tree over the cluster centroids, built in RAM on
+// first use, which skips clusters that can't lower the score. Same score as the default path.
+// Pays off for models with hundreds of clusters or more, over a few axes. Takes precedence
+// over EI_CLASSIFIER_ANOMALY_SOA. Single windows only, run_classifier_batch() keeps using
+// the structure-of-arrays batch kernel, which is faster than the tree per window.
+#ifndef EI_CLASSIFIER_ANOMALY_TREE
+#define EI_CLASSIFIER_ANOMALY_TREE                  0
+#endif // EI_CLASSIFIER_ANOMALY_TREE
+
+// Score the K-means anomaly block in fixed point, for targets without an FPU: 16 (int16) or 8
+// (int8), 0 for float. The scaler and the distances are integer math against the const
+// quantized clusters in model-parameters/anomaly_clusters_fixed.h, the float clusters aren't
+// linked. Regenerate that header with make -C benchmark anomaly_clusters_fixed whenever the
+// model is exported again. The score is within EI_CLASSIFIER_ANOM_FIXED_TOLERANCE of the float score, about
+// (sqrt(axes) + 1) / 2^frac_bits, where frac_bits is picked from the largest centroid.
+// That's roughly 1e-3 for int16. For int8 it's 0.17 for this model, and up to ~1 for models
+// with more axes or larger centroids (0.84 for 33 axes with centroids up to 8), the same order
+// as typical anomaly thresholds: only use 8 if the tolerance is well below your threshold.
+// Takes precedence over EI_CLASSIFIER_ANOMALY_TREE and EI_CLASSIFIER_ANOMALY_SOA.
+#ifndef EI_CLASSIFIER_ANOMALY_FIXED_POINT
+#define EI_CLASSIFIER_ANOMALY_FIXED_POINT           0
+#endif // EI_CLASSIFIER_ANOMALY_FIXED_POINT
+
 // no include checks in the compiler? then just include metadata and then ops_define (optional if on EON model)
 #ifndef __has_include
     #include "model-parameters/model_metadata.h"
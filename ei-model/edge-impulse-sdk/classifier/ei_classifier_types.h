@@ -51,8 +51,18 @@ typedef struct {
     int64_t dsp_us;
     int64_t classification_us;
     int64_t anomaly_us;
+    int64_t dsp_ns;
+    int64_t classification_ns;
+    int64_t anomaly_ns;
 } ei_impulse_result_timing_t;
 
+typedef struct {
+    int64_t dsp_us;             // summed over all windows
+    int64_t classification_us;  // summed over all windows
+    int64_t anomaly_us;         // summed over all windows
+    int64_t total_us;           // wall time for the whole batch
+} ei_impulse_batch_timing_t;
+
 typedef struct {
     ei_impulse_result_bounding_box_t *bounding_boxes;
     uint32_t bounding_boxes_count;
@@ -22,11 +22,20 @@
 
 #include "ei_run_dsp.h"
 #include "ei_classifier_types.h"
+#include "ei_classifier_config.h"
 #include "ei_signal_with_axes.h"
 #include "ei_performance_calibration.h"
 
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 
+#if EI_CLASSIFIER_ENABLE_THREAD_POOL == 1
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
 // for the release we'll put an actual studio version here
 #ifndef EI_CLASSIFIER_STUDIO_VERSION
 #define EI_CLASSIFIER_STUDIO_VERSION 2
@@ -41,7 +50,12 @@
 #endif
 
 #if EI_CLASSIFIER_HAS_ANOMALY == 1
+// fixed point only needs the quantized clusters, so the float ones aren't compiled in
+#if EI_CLASSIFIER_ANOMALY_FIXED_POINT != 0
+#include "model-parameters/anomaly_clusters_fixed.h"
+#else
 #include "model-parameters/anomaly_clusters.h"
+#endif
 #include "inferencing_engines/anomaly.h"
 #endif
 
@@ -148,33 +162,66 @@ extern "C" EI_IMPULSE_ERROR run_inference(
 }
 
 /**
- * @brief      Process a complete impulse
+ * @brief      Do inferencing over every row of a processed feature matrix. The model
+ *             runs per row, the anomaly scores for all rows at once.
  *
  * @param      impulse  struct with information about model and DSP
- * @param      signal   Sample data
- * @param      result   Output classifier results
+ * @param      fmatrix  Processed matrix, one window per row
+ * @param      results  Output classifier results, one per row
  * @param[in]  debug    Debug output enable
  *
  * @return     The ei impulse error.
  */
-extern "C" EI_IMPULSE_ERROR process_impulse(const ei_impulse_t *impulse,
-                                            signal_t *signal,
-                                            ei_impulse_result_t *result,
-                                            bool debug = false)
+static EI_IMPULSE_ERROR run_inference_batch(
+    const ei_impulse_t *impulse,
+    ei::matrix_t *fmatrix,
+    ei_impulse_result_t *results,
+    bool debug = false)
 {
+#if (EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_NONE && EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_DRPAI)
+    for (size_t ix = 0; ix < fmatrix->rows; ix++) {
+        ei::matrix_t fm(1, fmatrix->cols, fmatrix->get_row_ptr(ix));
+        EI_IMPULSE_ERROR nn_res = run_nn_inference(impulse, &fm, &results[ix], debug);
+        if (nn_res != EI_IMPULSE_OK) {
+            return nn_res;
+        }
+    }
+#endif
 
-#if (EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW)) || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI
-    // Shortcut for quantized image models
-    if (can_run_classifier_image_quantized(impulse) == EI_IMPULSE_OK) {
-        return run_classifier_image_quantized(impulse, signal, result, debug);
+#if EI_CLASSIFIER_HAS_ANOMALY == 1
+    if (impulse->has_anomaly) {
+        EI_IMPULSE_ERROR anomaly_res = inference_anomaly_invoke_batch(impulse, fmatrix, results, debug);
+        if (anomaly_res != EI_IMPULSE_OK) {
+            return anomaly_res;
+        }
     }
 #endif
 
-    memset(result, 0, sizeof(ei_impulse_result_t));
+    if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+        return EI_IMPULSE_CANCELED;
+    }
 
-    ei::matrix_t features_matrix(1, impulse->nn_input_frame_size);
+    return EI_IMPULSE_OK;
+}
 
-    uint64_t dsp_start_us = ei_read_timer_us();
+/**
+ * @brief      Run all DSP blocks of the impulse over a signal
+ *
+ * @param      impulse          struct with information about model and DSP
+ * @param      signal           Sample data
+ * @param      features_matrix  Output features (1 x nn_input_frame_size)
+ * @param      result           Output classifier results (DSP timing is set)
+ * @param[in]  debug            Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR process_impulse_dsp(const ei_impulse_t *impulse,
+                                            signal_t *signal,
+                                            ei::matrix_t *features_matrix,
+                                            ei_impulse_result_t *result,
+                                            bool debug)
+{
+    uint64_t dsp_start_ns = ei_read_timer_ns();
 
     size_t out_features_index = 0;
 
@@ -186,7 +233,7 @@ extern "C" EI_IMPULSE_ERROR process_impulse(const ei_impulse_t *impulse,
             return EI_IMPULSE_DSP_ERROR;
         }
 
-        ei::matrix_t fm(1, block.n_output_features, features_matrix.buffer + out_features_index);
+        ei::matrix_t fm(1, block.n_output_features, features_matrix->buffer + out_features_index);
 
 #if EIDSP_SIGNAL_C_FN_POINTER
         if (block.axes_size != impulse->raw_samples_per_frame) {
@@ -211,18 +258,54 @@ extern "C" EI_IMPULSE_ERROR process_impulse(const ei_impulse_t *impulse,
         out_features_index += block.n_output_features;
     }
 
-    result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp_ns = ei_read_timer_ns() - dsp_start_ns;
+    result->timing.dsp_us = result->timing.dsp_ns / 1000;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
     if (debug) {
         ei_printf("Features (%d ms.): ", result->timing.dsp);
-        for (size_t ix = 0; ix < features_matrix.cols; ix++) {
-            ei_printf_float(features_matrix.buffer[ix]);
+        for (size_t ix = 0; ix < features_matrix->cols; ix++) {
+            ei_printf_float(features_matrix->buffer[ix]);
             ei_printf(" ");
         }
         ei_printf("\n");
     }
 
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief      Process a complete impulse
+ *
+ * @param      impulse  struct with information about model and DSP
+ * @param      signal   Sample data
+ * @param      result   Output classifier results
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+extern "C" EI_IMPULSE_ERROR process_impulse(const ei_impulse_t *impulse,
+                                            signal_t *signal,
+                                            ei_impulse_result_t *result,
+                                            bool debug = false)
+{
+
+#if (EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW)) || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI
+    // Shortcut for quantized image models
+    if (can_run_classifier_image_quantized(impulse) == EI_IMPULSE_OK) {
+        return run_classifier_image_quantized(impulse, signal, result, debug);
+    }
+#endif
+
+    memset(result, 0, sizeof(ei_impulse_result_t));
+
+    ei::matrix_t features_matrix(1, impulse->nn_input_frame_size);
+
+    EI_IMPULSE_ERROR dsp_res = process_impulse_dsp(impulse, signal, &features_matrix, result, debug);
+    if (dsp_res != EI_IMPULSE_OK) {
+        return dsp_res;
+    }
+
     if (debug) {
         ei_printf("Running impulse...\n");
     }
@@ -231,6 +314,99 @@ extern "C" EI_IMPULSE_ERROR process_impulse(const ei_impulse_t *impulse,
 
 }
 
+/**
+ * @brief      Process a batch of windows. DSP runs for up to EI_CLASSIFIER_BATCH_SIZE
+ *             windows at a time into one features matrix, then the model runs over
+ *             every row and the anomaly scores for all rows at once. The model is kept
+ *             initialized for the whole batch.
+ *
+ * @param      impulse       struct with information about model and DSP
+ * @param      signals       Sample data, one signal per window
+ * @param      results       Output classifier results, one per window
+ * @param[in]  count         Number of windows
+ * @param      batch_timing  Optional, aggregated timing for the batch
+ * @param[in]  debug         Debug output enable
+ *
+ * @return     The ei impulse error. Stops at the first window that fails.
+ */
+extern "C" EI_IMPULSE_ERROR process_impulse_batch(const ei_impulse_t *impulse,
+                                                  signal_t *signals,
+                                                  ei_impulse_result_t *results,
+                                                  size_t count,
+                                                  ei_impulse_batch_timing_t *batch_timing = nullptr,
+                                                  bool debug = false)
+{
+    uint64_t batch_start_us = ei_read_timer_us();
+
+    if (batch_timing) {
+        memset(batch_timing, 0, sizeof(ei_impulse_batch_timing_t));
+    }
+
+    const size_t max_rows = count < EI_CLASSIFIER_BATCH_SIZE ? count : EI_CLASSIFIER_BATCH_SIZE;
+    ei::matrix_t features_matrix(max_rows > 0 ? max_rows : 1, impulse->nn_input_frame_size);
+    if (!features_matrix.buffer) {
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+    inference_tflite_batch_begin();
+#endif
+
+    EI_IMPULSE_ERROR res = EI_IMPULSE_OK;
+
+    for (size_t chunk_start = 0; chunk_start < count && res == EI_IMPULSE_OK; chunk_start += max_rows) {
+        size_t chunk_size = count - chunk_start < max_rows ? count - chunk_start : max_rows;
+
+        for (size_t ix = 0; ix < chunk_size && res == EI_IMPULSE_OK; ix++) {
+            ei_impulse_result_t *result = &results[chunk_start + ix];
+            signal_t *signal = &signals[chunk_start + ix];
+
+#if (EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW)) || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI
+            // quantized image models don't go through the features matrix
+            if (can_run_classifier_image_quantized(impulse) == EI_IMPULSE_OK) {
+                res = run_classifier_image_quantized(impulse, signal, result, debug);
+                continue;
+            }
+#endif
+
+            memset(result, 0, sizeof(ei_impulse_result_t));
+
+            ei::matrix_t fm(1, impulse->nn_input_frame_size, features_matrix.get_row_ptr(ix));
+            res = process_impulse_dsp(impulse, signal, &fm, result, debug);
+        }
+
+        bool run_features = res == EI_IMPULSE_OK;
+#if (EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW)) || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI
+        if (can_run_classifier_image_quantized(impulse) == EI_IMPULSE_OK) {
+            run_features = false;
+        }
+#endif
+
+        if (run_features) {
+            ei::matrix_t chunk_matrix(chunk_size, impulse->nn_input_frame_size, features_matrix.buffer);
+            res = run_inference_batch(impulse, &chunk_matrix, &results[chunk_start], debug);
+        }
+
+        if (batch_timing) {
+            for (size_t ix = 0; ix < chunk_size; ix++) {
+                batch_timing->dsp_us += results[chunk_start + ix].timing.dsp_us;
+                batch_timing->classification_us += results[chunk_start + ix].timing.classification_us;
+                batch_timing->anomaly_us += results[chunk_start + ix].timing.anomaly_us;
+            }
+        }
+    }
+
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+    inference_tflite_batch_end();
+#endif
+
+    if (batch_timing) {
+        batch_timing->total_us = ei_read_timer_us() - batch_start_us;
+    }
+
+    return res;
+}
+
 /**
  * @brief      Process a complete impulse for continuous inference
  *
@@ -257,7 +433,7 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(const ei_impulse_t *impul
 
     EI_IMPULSE_ERROR ei_impulse_error = EI_IMPULSE_OK;
 
-    uint64_t dsp_start_us = ei_read_timer_us();
+    uint64_t dsp_start_ns = ei_read_timer_ns();
 
     size_t out_features_index = 0;
     bool is_mfcc = false;
@@ -275,7 +451,8 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(const ei_impulse_t *impul
         ei::matrix_t fm(1, block.n_output_features,
                         static_features_matrix.buffer + out_features_index);
 
-        int (*extract_fn_slice)(ei::signal_t *signal, ei::matrix_t *output_matrix, void *config, const float frequency, matrix_size_t *out_matrix_size);
+        int (*extract_fn_slice)(ei::signal_t *signal, ei::matrix_t *output_matrix, void *config, const float frequency, matrix_size_t *out_matrix_size) = nullptr;
+        bool is_spectral_analysis = false;
 
         /* Switch to the slice version of the mfcc feature extract function */
         if (block.extract_fn == extract_mfcc_features) {
@@ -290,8 +467,16 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(const ei_impulse_t *impul
             extract_fn_slice = &extract_mfe_per_slice_features;
             is_mfe = true;
         }
+        else if (block.extract_fn == extract_spectral_analysis_features
+#if EI_CLASSIFIER_DSP_SPECIALIZED && EI_CLASSIFIER_STUDIO_VERSION < 3
+            || ei_dsp_is_specialized_spectral_analysis(block.extract_fn)
+#endif
+            ) {
+            /* Spectral analysis keeps a sliding window, and needs to know its length */
+            is_spectral_analysis = true;
+        }
         else {
-            ei_printf("ERR: Unknown extract function, only MFCC, MFE and spectrogram supported\n");
+            ei_printf("ERR: Unknown extract function, only MFCC, MFE, spectrogram and spectral analysis supported\n");
             return EI_IMPULSE_DSP_ERROR;
         }
 
@@ -302,12 +487,22 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(const ei_impulse_t *impul
             ei_printf("ERR: EIDSP_SIGNAL_C_FN_POINTER can only be used when all axes are selected for DSP blocks\n");
             return EI_IMPULSE_DSP_ERROR;
         }
-        int ret = extract_fn_slice(signal, &fm, block.config, impulse->frequency, &features_written);
+        signal_t *block_signal = signal;
 #else
         SignalWithAxes swa(signal, block.axes, block.axes_size, impulse);
-        int ret = extract_fn_slice(swa.get_signal(), &fm, block.config, impulse->frequency, &features_written);
+        signal_t *block_signal = swa.get_signal();
 #endif
 
+        int ret;
+        if (is_spectral_analysis) {
+            ret = extract_spectral_analysis_per_slice_features(block_signal, &fm, block.config,
+                impulse->frequency, impulse->raw_sample_count, ix, impulse->dsp_blocks_size,
+                &features_written);
+        }
+        else {
+            ret = extract_fn_slice(block_signal, &fm, block.config, impulse->frequency, &features_written);
+        }
+
         if (ret != EIDSP_OK) {
             ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
             return EI_IMPULSE_DSP_ERROR;
@@ -322,7 +517,8 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(const ei_impulse_t *impul
         out_features_index += block.n_output_features;
     }
 
-    result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp_ns = ei_read_timer_ns() - dsp_start_ns;
+    result->timing.dsp_us = result->timing.dsp_ns / 1000;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
     if (debug) {
@@ -335,7 +531,7 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(const ei_impulse_t *impul
     }
 
     if (classifier_continuous_features_written >= impulse->nn_input_frame_size) {
-        dsp_start_us = ei_read_timer_us();
+        dsp_start_ns = ei_read_timer_ns();
         ei::matrix_t classify_matrix(1, impulse->nn_input_frame_size);
 
         /* Create a copy of the matrix for normalization */
@@ -352,7 +548,8 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(const ei_impulse_t *impul
         else if (is_mfe) {
             calc_cepstral_mean_and_var_normalization_mfe(&classify_matrix, impulse->dsp_blocks[0].config);
         }
-        result->timing.dsp_us += ei_read_timer_us() - dsp_start_us;
+        result->timing.dsp_ns += ei_read_timer_ns() - dsp_start_ns;
+        result->timing.dsp_us = result->timing.dsp_ns / 1000;
         result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
         if (debug) {
@@ -606,6 +803,7 @@ extern "C" void run_classifier_init()
 
     classifier_continuous_features_written = 0;
     ei_dsp_clear_continuous_audio_state();
+    ei_dsp_clear_continuous_spectral_state();
 
 #if EI_CLASSIFIER_CALIBRATION_ENABLED
 
@@ -631,6 +829,7 @@ __attribute__((unused)) void run_classifier_init(const ei_impulse_t *impulse)
 {
     classifier_continuous_features_written = 0;
     ei_dsp_clear_continuous_audio_state();
+    ei_dsp_clear_continuous_spectral_state();
 
 #if EI_CLASSIFIER_CALIBRATION_ENABLED
     const ei_model_performance_calibration_t *calibration = &ei_calibration;
@@ -647,6 +846,15 @@ extern "C" void run_classifier_deinit(void)
     if((void *)avg_scores != NULL) {
         delete avg_scores;
     }
+
+#if (EI_CLASSIFIER_PERSISTENT_SESSION == 1) && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE)
+    inference_tflite_session_deinit();
+#endif
+
+    ei_dsp_clear_continuous_spectral_state();
+    numpy::clear_fft_plan_cache();
+    speechpy::feature::clear_mel_filterbank_cache();
+    spectral::wavelet::clear_wavelet_workspace_cache();
 }
 
 /**
@@ -732,6 +940,312 @@ __attribute__((unused)) EI_IMPULSE_ERROR run_classifier(
     return process_impulse(impulse, signal, result, debug);
 }
 
+/**
+ * Run the classifier over a batch of windows, e.g. to re-score recorded data.
+ * Gives the same results as calling run_classifier for every window, but
+ * keeps the model initialized for the whole batch.
+ * @param signals Array of signals, one per window
+ * @param results Array to store the results in, one per window
+ * @param count Number of windows
+ * @param batch_timing Optional, aggregated timing for the batch (per window timing is in results)
+ * @param debug Whether to show debug messages (default: false)
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_batch(
+    signal_t *signals,
+    ei_impulse_result_t *results,
+    size_t count,
+    ei_impulse_batch_timing_t *batch_timing = nullptr,
+    bool debug = false)
+{
+#if EI_CLASSIFIER_STUDIO_VERSION < 3
+        const ei_impulse_t impulse = ei_construct_impulse();
+#else
+       const ei_impulse_t impulse = ei_default_impulse;
+#endif
+    return process_impulse_batch(&impulse, signals, results, count, batch_timing, debug);
+}
+
+/**
+ * Run the impulse over a batch of windows
+ * @param impulse struct with information about model and DSP
+ * @param signals Array of signals, one per window
+ * @param results Array to store the results in, one per window
+ * @param count Number of windows
+ * @param batch_timing Optional, aggregated timing for the batch (per window timing is in results)
+ * @param debug Whether to show debug messages (default: false)
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_batch(
+    const ei_impulse_t *impulse,
+    signal_t *signals,
+    ei_impulse_result_t *results,
+    size_t count,
+    ei_impulse_batch_timing_t *batch_timing = nullptr,
+    bool debug = false)
+{
+    return process_impulse_batch(impulse, signals, results, count, batch_timing, debug);
+}
+
+#if EI_CLASSIFIER_ENABLE_THREAD_POOL == 1
+
+// the FFT plan, mel filterbank and Butterworth caches are shared between threads otherwise
+#if EIDSP_CACHE_THREAD_LOCAL != 1
+#error "EI_CLASSIFIER_ENABLE_THREAD_POOL needs EIDSP_CACHE_THREAD_LOCAL=1 (set it for the whole project)"
+#endif
+
+/**
+ * Runs batches of windows on a fixed set of worker threads (Linux / POSIX hosts).
+ * The threads, and every worker's model instance (see trained_model_create()) and
+ * DSP scratch buffer, are created in the constructor and live until the pool is
+ * destroyed. run() queues the batch and wakes the workers, windows are handed out
+ * one at a time to whichever worker is free, so slow windows don't hold up the
+ * others, and results are written in the same order as the signals.
+ * The calling thread only waits, its DSP caches are left alone; the workers free
+ * theirs when they exit. run() returns once every worker has picked up the batch and
+ * gone idle again, so no worker still holds the signals or results of a previous
+ * batch. run() should be called from one thread at a time.
+ *
+ * Only EON compiled classification models can run in parallel, other impulses
+ * fall back to run_classifier_batch on the calling thread.
+ */
+class ClassifierBatchPool {
+public:
+    /**
+     * @param impulse struct with information about model and DSP
+     * @param threads Number of worker threads (0 = one per core)
+     */
+    ClassifierBatchPool(const ei_impulse_t *impulse, size_t threads = 0):
+        _impulse(impulse), _threads(threads)
+    {
+        if (_threads == 0) {
+            _threads = std::thread::hardware_concurrency();
+        }
+        if (_threads == 0) {
+            _threads = 1;
+        }
+
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+        // object detection runs on the calling thread, see run()
+        if (_impulse->object_detection) {
+            return;
+        }
+
+        _workers.resize(_threads);
+        for (worker_t &worker : _workers) {
+            worker.model = trained_model_create(ei_aligned_calloc, ei_aligned_free);
+            if (!worker.model) {
+                _init_error = EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+                return;
+            }
+            worker.features = (float*)ei_calloc(_impulse->nn_input_frame_size, sizeof(float));
+            if (!worker.features) {
+                _init_error = EI_IMPULSE_ALLOC_FAILED;
+                return;
+            }
+        }
+
+        for (size_t ix = 0; ix < _threads; ix++) {
+            _thread_handles.emplace_back(&ClassifierBatchPool::worker, this, ix);
+        }
+#endif
+    }
+
+    ~ClassifierBatchPool() {
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _work_cv.notify_all();
+        for (std::thread &thread : _thread_handles) {
+            thread.join();
+        }
+
+        for (worker_t &worker : _workers) {
+            if (worker.model) {
+                trained_model_destroy(worker.model, ei_aligned_free);
+            }
+            if (worker.features) {
+                ei_free(worker.features);
+            }
+        }
+#endif
+    }
+
+    ClassifierBatchPool(const ClassifierBatchPool&) = delete;
+    ClassifierBatchPool& operator=(const ClassifierBatchPool&) = delete;
+
+    size_t threads() const {
+        return _threads;
+    }
+
+    /**
+     * Run the impulse over a batch of windows
+     * @param signals Array of signals, one per window
+     * @param results Array to store the results in, one per window
+     * @param count Number of windows
+     * @param batch_timing Optional, aggregated timing for the batch (per window timing is in results)
+     * @returns EI_IMPULSE_OK, or the error of the first window that failed
+     */
+    EI_IMPULSE_ERROR run(
+        signal_t *signals,
+        ei_impulse_result_t *results,
+        size_t count,
+        ei_impulse_batch_timing_t *batch_timing = nullptr)
+    {
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+        // object detection results point into static buffers, so can't run in parallel
+        if (_impulse->object_detection) {
+            return process_impulse_batch(_impulse, signals, results, count, batch_timing, false);
+        }
+
+        if (_init_error != EI_IMPULSE_OK) {
+            return _init_error;
+        }
+
+        uint64_t batch_start_us = ei_read_timer_us();
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _signals = signals;
+            _results = results;
+            _count = count;
+            _next_window.store(0);
+            _error.store(EI_IMPULSE_OK);
+            _joined = 0;
+            _generation++;
+            _work_cv.notify_all();
+
+            // a worker only leaves run_windows once every window is claimed (or a window failed),
+            // so done when all of them joined this batch and none is still on a window
+            _done_cv.wait(lock, [this] {
+                return _joined == _thread_handles.size() && _busy == 0;
+            });
+        }
+
+        if (batch_timing) {
+            memset(batch_timing, 0, sizeof(ei_impulse_batch_timing_t));
+            for (size_t ix = 0; ix < count; ix++) {
+                batch_timing->dsp_us += results[ix].timing.dsp_us;
+                batch_timing->classification_us += results[ix].timing.classification_us;
+                batch_timing->anomaly_us += results[ix].timing.anomaly_us;
+            }
+            batch_timing->total_us = ei_read_timer_us() - batch_start_us;
+        }
+
+        return _error.load();
+#else
+        return process_impulse_batch(_impulse, signals, results, count, batch_timing, false);
+#endif
+    }
+
+private:
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+    typedef struct {
+        trained_model_ctx_t *model;
+        float *features;
+    } worker_t;
+
+    // a worker's copy of the batch it joined
+    typedef struct {
+        signal_t *signals;
+        ei_impulse_result_t *results;
+        size_t count;
+    } batch_t;
+
+    void worker(size_t worker_ix) {
+        worker_t *worker = &_workers[worker_ix];
+        ei::matrix_t features_matrix(1, _impulse->nn_input_frame_size, worker->features);
+        uint64_t generation = 0;
+        batch_t batch;
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _work_cv.wait(lock, [&] { return _stop || _generation != generation; });
+                if (_stop) {
+                    break;
+                }
+                generation = _generation;
+                batch.signals = _signals;
+                batch.results = _results;
+                batch.count = _count;
+                _joined++;
+                _busy++;
+            }
+
+            run_windows(worker, &features_matrix, &batch);
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _busy--;
+                if (_busy == 0) {
+                    _done_cv.notify_all();
+                }
+            }
+        }
+
+        // this thread is owned by the pool, so free its DSP caches now that it exits
+        numpy::clear_fft_plan_cache();
+        speechpy::feature::clear_mel_filterbank_cache();
+        spectral::wavelet::clear_wavelet_workspace_cache();
+    }
+
+    void run_windows(worker_t *worker, ei::matrix_t *features_matrix, const batch_t *batch) {
+        while (_error.load() == EI_IMPULSE_OK) {
+            size_t window_ix = _next_window.fetch_add(1);
+            if (window_ix >= batch->count) {
+                break;
+            }
+
+            ei_impulse_result_t *result = &batch->results[window_ix];
+            memset(result, 0, sizeof(ei_impulse_result_t));
+
+            EI_IMPULSE_ERROR res = process_impulse_dsp(_impulse, &batch->signals[window_ix], features_matrix, result, false);
+            if (res == EI_IMPULSE_OK) {
+                res = run_nn_inference_ctx(_impulse, worker->model, features_matrix, result, false);
+            }
+#if EI_CLASSIFIER_HAS_ANOMALY == 1
+            if (res == EI_IMPULSE_OK && _impulse->has_anomaly) {
+                res = inference_anomaly_invoke(_impulse, features_matrix, result, false);
+            }
+#endif
+            if (res != EI_IMPULSE_OK) {
+                set_error(res);
+            }
+        }
+    }
+
+    void set_error(EI_IMPULSE_ERROR error) {
+        EI_IMPULSE_ERROR expected = EI_IMPULSE_OK;
+        _error.compare_exchange_strong(expected, error);
+    }
+
+    std::vector<worker_t> _workers;
+    std::vector<std::thread> _thread_handles;
+    EI_IMPULSE_ERROR _init_error = EI_IMPULSE_OK;
+
+    // the current batch, guarded by _mutex (windows are claimed through _next_window,
+    // which run() only resets once every worker is idle)
+    std::mutex _mutex;
+    std::condition_variable _work_cv;
+    std::condition_variable _done_cv;
+    uint64_t _generation = 0;
+    size_t _busy = 0;
+    size_t _joined = 0;
+    bool _stop = false;
+    signal_t *_signals = nullptr;
+    ei_impulse_result_t *_results = nullptr;
+    size_t _count = 0;
+    std::atomic<size_t> _next_window { 0 };
+    std::atomic<EI_IMPULSE_ERROR> _error { EI_IMPULSE_OK };
+#endif
+
+    const ei_impulse_t *_impulse;
+    size_t _threads;
+};
+
+#endif // EI_CLASSIFIER_ENABLE_THREAD_POOL == 1
+
 /* Deprecated functions ------------------------------------------------------- */
 
 /* These functions are being deprecated and possibly will be removed or moved in future.
@@ -49,6 +49,23 @@ static float *ei_dsp_cont_current_frame = nullptr;
 static size_t ei_dsp_cont_current_frame_size = 0;
 static int ei_dsp_cont_current_frame_ix = 0;
 
+/**
+ * Copy a buffer with interleaved axes (frames x axes) into a matrix with one row per axis.
+ * Saves a copy + transpose when the signal is available in memory.
+ */
+__attribute__((unused)) static void copy_interleaved_to_rows(const float *buffer, matrix_t *output_matrix)
+{
+    const size_t axes = output_matrix->rows;
+    const size_t frames = output_matrix->cols;
+
+    for (size_t axis_ix = 0; axis_ix < axes; axis_ix++) {
+        float *row = output_matrix->buffer + (axis_ix * frames);
+        for (size_t frame_ix = 0; frame_ix < frames; frame_ix++) {
+            row[frame_ix] = buffer[frame_ix * axes + axis_ix];
+        }
+    }
+}
+
 __attribute__((unused)) int extract_spectral_analysis_features(
     signal_t *signal,
     matrix_t *output_matrix,
@@ -57,13 +74,26 @@ __attribute__((unused)) int extract_spectral_analysis_features(
 {
     ei_dsp_config_spectral_analysis_t *config = (ei_dsp_config_spectral_analysis_t *)config_ptr;
 
+    // the FFT block (v1 and v2) wants one row per axis, if the signal is in memory we can
+    // read it that way directly, rather than copying it over and transposing in place
+    const bool read_transposed = signal->buffer != nullptr
+        && (config->implementation_version == 1 || config->implementation_version == 2)
+        && strcmp(config->analysis_type, "Wavelet") != 0;
+
     // input matrix from the raw signal
-    matrix_t input_matrix(signal->total_length / config->axes, config->axes);
+    matrix_t input_matrix(
+        read_transposed ? config->axes : signal->total_length / config->axes,
+        read_transposed ? signal->total_length / config->axes : config->axes);
     if (!input_matrix.buffer) {
         EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
 
-    signal->get_data(0, signal->total_length, input_matrix.buffer);
+    if (read_transposed) {
+        copy_interleaved_to_rows(signal->buffer, &input_matrix);
+    }
+    else {
+        signal->get_data(0, signal->total_length, input_matrix.buffer);
+    }
 
 #if EI_DSP_PARAMS_SPECTRAL_ANALYSIS_ANALYSIS_TYPE_WAVELET || EI_DSP_PARAMS_ALL
     if (strcmp(config->analysis_type, "Wavelet") == 0) {
@@ -78,13 +108,15 @@ __attribute__((unused)) int extract_spectral_analysis_features(
                 &input_matrix,
                 output_matrix,
                 config,
-                frequency);
+                frequency,
+                read_transposed);
         } else {
             return spectral::feature::extract_spectral_analysis_features_v2(
                 &input_matrix,
                 output_matrix,
                 config,
-                frequency);
+                frequency,
+                read_transposed);
         }
     }
 #endif
@@ -95,35 +127,176 @@ __attribute__((unused)) int extract_spectral_analysis_features(
             &input_matrix,
             output_matrix,
             config,
-            frequency);
+            frequency,
+            read_transposed);
     }
     if (config->implementation_version == 2) {
         return spectral::feature::extract_spectral_analysis_features_v2(
             &input_matrix,
             output_matrix,
             config,
-            frequency);
+            frequency,
+            read_transposed);
     }
 #endif
     return EIDSP_NOT_SUPPORTED;
 }
 
-__attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
-    ei_dsp_config_raw_t config = *((ei_dsp_config_raw_t*)config_ptr);
+/**
+ * Spectral analysis specialized on a config that's fixed at compile time (used from
+ * dsp_blocks.h when EI_CLASSIFIER_DSP_SPECIALIZED is set). static_config_t describes the
+ * shape of the config (see ei_dsp_config_*_static_t in model-parameters/dsp_config_static.h),
+ * and is checked against the config on every call; v1 FFT blocks run without heap allocations
+ * for the signal and features, other configs (or a signal that's not a full window) go through
+ * extract_spectral_analysis_features.
+ */
+template<typename static_config_t>
+__attribute__((unused)) int extract_spectral_analysis_features_static(
+    signal_t *signal,
+    matrix_t *output_matrix,
+    void *config_ptr,
+    const float frequency)
+{
+    constexpr size_t axes = static_config_t::axes;
+    constexpr size_t frames = static_config_t::frames;
 
-    // input matrix from the raw signal
-    matrix_t input_matrix(signal->total_length / config.axes, config.axes);
+    EI_TRY(spectral::feature::check_static_config<static_config_t>(
+        (ei_dsp_config_spectral_analysis_t *)config_ptr));
+
+    if (static_config_t::implementation_version != 1 || !static_config_t::analysis_fft ||
+            signal->total_length != axes * frames) {
+        return extract_spectral_analysis_features(signal, output_matrix, config_ptr, frequency);
+    }
+
+    ei_dsp_config_spectral_analysis_t *config = (ei_dsp_config_spectral_analysis_t *)config_ptr;
+
+    // one row per axis, transposed while reading the signal
+    float input_buffer[axes * frames];
+    matrix_t input_matrix(axes, frames, input_buffer);
+
+    if (signal->buffer != nullptr) {
+        copy_interleaved_to_rows(signal->buffer, &input_matrix);
+    }
+    else {
+        constexpr size_t read_frames = 16;
+        float read_buffer[read_frames * axes];
+
+        for (size_t frame_ix = 0; frame_ix < frames; frame_ix += read_frames) {
+            const size_t frame_count = frame_ix + read_frames > frames ? frames - frame_ix : read_frames;
+            EI_TRY(signal->get_data(frame_ix * axes, frame_count * axes, read_buffer));
+
+            for (size_t ix = 0; ix < frame_count; ix++) {
+                for (size_t axis_ix = 0; axis_ix < axes; axis_ix++) {
+                    input_buffer[axis_ix * frames + frame_ix + ix] = read_buffer[ix * axes + axis_ix];
+                }
+            }
+        }
+    }
+
+    EI_TRY(numpy::scale(&input_matrix, config->scale_axes));
+
+    return spectral::feature::extract_spectral_analysis_features_v1_static<static_config_t>(
+        &input_matrix,
+        output_matrix,
+        config,
+        frequency);
+}
+
+// sliding window state for continuous spectral analysis, one per DSP block (indexed by block),
+// allocated on first use
+static spectral::feature::spectral_stream_t *ei_dsp_cont_spectral_streams = nullptr;
+static size_t ei_dsp_cont_spectral_streams_size = 0;
+
+/**
+ * Clear the sliding windows of continuous spectral analysis (of all DSP blocks).
+ */
+__attribute__((unused)) void ei_dsp_clear_continuous_spectral_state() {
+    for (size_t ix = 0; ix < ei_dsp_cont_spectral_streams_size; ix++) {
+        spectral::feature::spectral_stream_free(&ei_dsp_cont_spectral_streams[ix]);
+    }
+    if (ei_dsp_cont_spectral_streams) {
+        ei_free(ei_dsp_cont_spectral_streams);
+    }
+    ei_dsp_cont_spectral_streams = nullptr;
+    ei_dsp_cont_spectral_streams_size = 0;
+}
+
+/**
+ * Spectral analysis over a sliding window, for run_classifier_continuous.
+ * Each call adds a slice to the window, features are written once the window is full.
+ * @param signal Slice of the signal (frames x axes)
+ * @param output_matrix Output matrix
+ * @param config_ptr Spectral analysis config
+ * @param frequency Sampling frequency
+ * @param window_frames Number of frames in the full window
+ * @param block_ix Index of the DSP block in the impulse, every block keeps its own window
+ * @param block_count Number of DSP blocks in the impulse
+ * @param matrix_size_out Out: size of the features written (0 while the window is not full yet)
+ */
+__attribute__((unused)) int extract_spectral_analysis_per_slice_features(
+    signal_t *signal,
+    matrix_t *output_matrix,
+    void *config_ptr,
+    const float frequency,
+    size_t window_frames,
+    size_t block_ix,
+    size_t block_count,
+    matrix_size_t *matrix_size_out)
+{
+    ei_dsp_config_spectral_analysis_t *config = (ei_dsp_config_spectral_analysis_t *)config_ptr;
+
+    matrix_size_out->rows = 0;
+    matrix_size_out->cols = 0;
+
+    if (block_ix >= block_count) {
+        EIDSP_ERR(EIDSP_OUT_OF_BOUNDS);
+    }
+
+    if (ei_dsp_cont_spectral_streams_size != block_count) {
+        ei_dsp_clear_continuous_spectral_state();
+
+        ei_dsp_cont_spectral_streams = (spectral::feature::spectral_stream_t *)ei_calloc(
+            block_count, sizeof(spectral::feature::spectral_stream_t));
+        if (!ei_dsp_cont_spectral_streams) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        ei_dsp_cont_spectral_streams_size = block_count;
+    }
+
+    spectral::feature::spectral_stream_t *stream = &ei_dsp_cont_spectral_streams[block_ix];
+    if (stream->config != config || stream->window_frames != window_frames) {
+        spectral::feature::spectral_stream_free(stream);
+        EI_TRY(spectral::feature::spectral_stream_init(stream, config, window_frames));
+    }
+
+    // input matrix from the slice
+    matrix_t input_matrix(signal->total_length / config->axes, config->axes);
     if (!input_matrix.buffer) {
         EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
+
     signal->get_data(0, signal->total_length, input_matrix.buffer);
 
-    // scale the signal
-    int ret = numpy::scale(&input_matrix, config.scale_axes);
+    EI_TRY(spectral::feature::spectral_stream_add_slice(stream, &input_matrix));
+
+    int ret = spectral::feature::spectral_stream_get_features(stream, output_matrix, frequency);
+    if (ret == EIDSP_BUFFER_SIZE_MISMATCH) {
+        // window not full yet
+        return EIDSP_OK;
+    }
     if (ret != EIDSP_OK) {
         EIDSP_ERR(ret);
     }
 
+    matrix_size_out->rows = output_matrix->rows;
+    matrix_size_out->cols = output_matrix->cols;
+
+    return EIDSP_OK;
+}
+
+__attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+    ei_dsp_config_raw_t config = *((ei_dsp_config_raw_t*)config_ptr);
+
     // Because of rounding errors during re-sampling the output size of the block might be
     // smaller than the input of the block. Make sure we don't write outside of the bounds
     // of the array:
@@ -133,6 +306,27 @@ __attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *out
         els_to_copy = output_matrix->rows * output_matrix->cols;
     }
 
+    // signal is in memory, scale straight into the output
+    if (signal->buffer) {
+        for (size_t ix = 0; ix < els_to_copy; ix++) {
+            output_matrix->buffer[ix] = signal->buffer[ix] * config.scale_axes;
+        }
+        return EIDSP_OK;
+    }
+
+    // input matrix from the raw signal
+    matrix_t input_matrix(signal->total_length / config.axes, config.axes);
+    if (!input_matrix.buffer) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+    signal->get_data(0, signal->total_length, input_matrix.buffer);
+
+    // scale the signal
+    int ret = numpy::scale(&input_matrix, config.scale_axes);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
     memcpy(output_matrix->buffer, input_matrix.buffer, els_to_copy * sizeof(float));
 
     return EIDSP_OK;
@@ -157,12 +351,20 @@ __attribute__((unused)) int extract_flatten_features(signal_t *signal, matrix_t
 
     int ret;
 
-    // input matrix from the raw signal
-    matrix_t input_matrix(signal->total_length / config.axes, config.axes);
+    // input matrix from the raw signal, if the signal is in memory read it with one row per axis
+    matrix_t input_matrix(
+        signal->buffer ? config.axes : signal->total_length / config.axes,
+        signal->buffer ? signal->total_length / config.axes : config.axes);
     if (!input_matrix.buffer) {
         EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
-    signal->get_data(0, signal->total_length, input_matrix.buffer);
+
+    if (signal->buffer) {
+        copy_interleaved_to_rows(signal->buffer, &input_matrix);
+    }
+    else {
+        signal->get_data(0, signal->total_length, input_matrix.buffer);
+    }
 
     // scale the signal
     ret = numpy::scale(&input_matrix, config.scale_axes);
@@ -172,10 +374,12 @@ __attribute__((unused)) int extract_flatten_features(signal_t *signal, matrix_t
     }
 
     // transpose the matrix so we have one row per axis (nifty!)
-    ret = numpy::transpose(&input_matrix);
-    if (ret != EIDSP_OK) {
-        ei_printf("ERR: Failed to transpose matrix (%d)\n", ret);
-        EIDSP_ERR(ret);
+    if (!signal->buffer) {
+        ret = numpy::transpose(&input_matrix);
+        if (ret != EIDSP_OK) {
+            ei_printf("ERR: Failed to transpose matrix (%d)\n", ret);
+            EIDSP_ERR(ret);
+        }
     }
 
     size_t out_matrix_ix = 0;
@@ -1359,6 +1563,7 @@ __attribute__((unused)) int extract_image_features_quantized(const ei_impulse_t
 }
 #endif // (EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1) && (EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_DRPAI)
 
+
 /**
  * Clear all state regarding continuous audio. Invoke this function after continuous audio loop ends.
  */
@@ -24,6 +24,12 @@
 
 #if !EIDSP_SIGNAL_C_FN_POINTER
 
+// Number of floats read from the original signal at once when selecting axes (stack allocated).
+// Frames with more samples than this are read sample by sample.
+#ifndef EI_SIGNAL_WITH_AXES_READ_BUFFER_SIZE
+#define EI_SIGNAL_WITH_AXES_READ_BUFFER_SIZE    96
+#endif // EI_SIGNAL_WITH_AXES_READ_BUFFER_SIZE
+
 using namespace ei;
 
 class SignalWithAxes {
@@ -51,9 +57,48 @@ public:
     }
 
     int get_data(size_t offset, size_t length, float *out_ptr) {
-        size_t offset_on_original_signal = offset / _axes_count * _impulse->raw_samples_per_frame;
-        size_t length_on_original_signal = length / _axes_count * _impulse->raw_samples_per_frame;
+        const size_t samples_per_frame = _impulse->raw_samples_per_frame;
+        size_t offset_on_original_signal = offset / _axes_count * samples_per_frame;
+        size_t length_on_original_signal = length / _axes_count * samples_per_frame;
+
+        // frame larger than the read buffer, fall back to reading sample by sample
+        if (samples_per_frame > EI_SIGNAL_WITH_AXES_READ_BUFFER_SIZE) {
+            return get_data_per_sample(offset_on_original_signal, length_on_original_signal, out_ptr);
+        }
+
+        // read as many full frames as fit in the buffer at once, then pick out the axes
+        float buffer[EI_SIGNAL_WITH_AXES_READ_BUFFER_SIZE];
+        const size_t frames_per_read = EI_SIGNAL_WITH_AXES_READ_BUFFER_SIZE / samples_per_frame;
+
+        size_t out_ptr_ix = 0;
+        size_t ix = offset_on_original_signal;
+        const size_t end = offset_on_original_signal + length_on_original_signal;
+
+        while (ix < end) {
+            size_t read_length = frames_per_read * samples_per_frame;
+            if (read_length > end - ix) {
+                read_length = end - ix;
+            }
+
+            int r = _original_signal->get_data(ix, read_length, buffer);
+            if (r != 0) {
+                return r;
+            }
 
+            for (size_t frame_ix = 0; frame_ix < read_length; frame_ix += samples_per_frame) {
+                for (size_t axis_ix = 0; axis_ix < this->_axes_count; axis_ix++) {
+                    out_ptr[out_ptr_ix++] = buffer[frame_ix + _axes[axis_ix]];
+                }
+            }
+
+            ix += read_length;
+        }
+
+        return 0;
+    }
+
+private:
+    int get_data_per_sample(size_t offset_on_original_signal, size_t length_on_original_signal, float *out_ptr) {
         size_t out_ptr_ix = 0;
 
         for (size_t ix = offset_on_original_signal; ix < offset_on_original_signal + length_on_original_signal; ix += _impulse->raw_samples_per_frame) {
@@ -68,7 +113,6 @@ public:
         return 0;
     }
 
-private:
     signal_t *_original_signal;
     uint8_t *_axes;
     size_t _axes_count;
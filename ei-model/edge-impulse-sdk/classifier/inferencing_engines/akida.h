@@ -232,11 +232,11 @@ EI_IMPULSE_ERROR run_nn_inference(
     }
 
     // Run inference on AKD1000
-    uint64_t ctx_start_us = ei_read_timer_us();
+    uint64_t ctx_start_ns = ei_read_timer_ns();
     py::array_t<float> potentials = model_predict(input_data);
     // TODO: 'forward' is returning int8 or int32, but EI SDK supports int8 or float32 only
     // py::array_t<float> potentials = model_forward(input_data);
-    uint64_t ctx_end_us = ei_read_timer_us();
+    uint64_t ctx_end_ns = ei_read_timer_ns();
 
     potentials = potentials.squeeze();
 
@@ -284,7 +284,8 @@ EI_IMPULSE_ERROR run_nn_inference(
     active_power = (active_power/pwr_events.size()) - floor_power;
 #endif
 
-    result->timing.classification_us = ctx_end_us - ctx_start_us;
+    result->timing.classification_ns = ctx_end_ns - ctx_start_ns;
+    result->timing.classification_us = result->timing.classification_ns / 1000;
     result->timing.classification = (int)(result->timing.classification_us / 1000);
 
     // clear info
@@ -26,6 +26,52 @@
 #include "edge-impulse-sdk/classifier/ei_classifier_types.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+
+#if EI_CLASSIFIER_ANOMALY_FIXED_POINT == 0
+#if EI_CLASSIFIER_ANOMALY_TREE == 1
+/**
+ * Ball tree over the clusters of this model, built on first use
+ */
+static const ei_classifier_anom_tree_t *get_anomaly_clusters_tree()
+{
+    static ei_classifier_anom_tree_node_t nodes[EI_CLASSIFIER_ANOM_TREE_MAX_NODES(EI_CLASSIFIER_ANOM_CLUSTER_COUNT)];
+    static float centers[EI_CLASSIFIER_ANOM_AXIS_SIZE * EI_CLASSIFIER_ANOM_TREE_MAX_NODES(EI_CLASSIFIER_ANOM_CLUSTER_COUNT)];
+    static uint32_t index[EI_CLASSIFIER_ANOM_CLUSTER_COUNT];
+    static ei_classifier_anom_tree_t tree;
+    // initialization of a function-local static is thread safe
+    static const bool initialized = (init_clusters_tree(
+        &tree,
+        ei_classifier_anom_clusters,
+        EI_CLASSIFIER_ANOM_CLUSTER_COUNT,
+        EI_CLASSIFIER_ANOM_AXIS_SIZE,
+        nodes,
+        centers,
+        index), true);
+    (void)initialized;
+    return &tree;
+}
+#endif // EI_CLASSIFIER_ANOMALY_TREE
+
+/**
+ * Clusters of this model in structure-of-arrays layout, set up on first use. Batches are
+ * always scored against these, single windows with EI_CLASSIFIER_ANOMALY_SOA.
+ */
+static const ei_classifier_anom_clusters_soa_t *get_anomaly_clusters_soa()
+{
+    static float buffer[EI_CLASSIFIER_ANOM_SOA_SIZE(EI_CLASSIFIER_ANOM_AXIS_SIZE, EI_CLASSIFIER_ANOM_CLUSTER_COUNT)];
+    static ei_classifier_anom_clusters_soa_t soa;
+    // initialization of a function-local static is thread safe
+    static const bool initialized = (init_clusters_soa(
+        &soa,
+        ei_classifier_anom_clusters,
+        EI_CLASSIFIER_ANOM_CLUSTER_COUNT,
+        EI_CLASSIFIER_ANOM_AXIS_SIZE,
+        buffer), true);
+    (void)initialized;
+    return &soa;
+}
+#endif // EI_CLASSIFIER_ANOMALY_FIXED_POINT == 0
 
 EI_IMPULSE_ERROR inference_anomaly_invoke(const ei_impulse_t *impulse,
                                           ei::matrix_t *fmatrix,
@@ -33,30 +79,106 @@ EI_IMPULSE_ERROR inference_anomaly_invoke(const ei_impulse_t *impulse,
                                           bool debug = false)
 {
 
-    uint64_t anomaly_start_ms = ei_read_timer_ms();
+    uint64_t anomaly_start_ns = ei_read_timer_ns();
 
     float input[EI_CLASSIFIER_ANOM_AXIS_SIZE];
     for (size_t ix = 0; ix < EI_CLASSIFIER_ANOM_AXIS_SIZE; ix++) {
         input[ix] = fmatrix->buffer[EI_CLASSIFIER_ANOM_AXIS[ix]];
     }
+#if EI_CLASSIFIER_ANOMALY_FIXED_POINT != 0
+    int16_t input_fixed[EI_CLASSIFIER_ANOM_AXIS_SIZE];
+    standard_scaler_fixed(input, &ei_classifier_anom_clusters_fixed, input_fixed);
+    float anomaly = get_min_distance_to_cluster_fixed(input_fixed, &ei_classifier_anom_clusters_fixed);
+#else
     standard_scaler(input, ei_classifier_anom_scale, ei_classifier_anom_mean, EI_CLASSIFIER_ANOM_AXIS_SIZE);
+#if EI_CLASSIFIER_ANOMALY_TREE == 1
+    float anomaly = get_min_distance_to_cluster_tree(input, get_anomaly_clusters_tree());
+#elif EI_CLASSIFIER_ANOMALY_SOA == 1
+    float anomaly = get_min_distance_to_cluster_soa(input, get_anomaly_clusters_soa());
+#else
     float anomaly = get_min_distance_to_cluster(
         input, EI_CLASSIFIER_ANOM_AXIS_SIZE, ei_classifier_anom_clusters, EI_CLASSIFIER_ANOM_CLUSTER_COUNT);
+#endif
+#endif // EI_CLASSIFIER_ANOMALY_FIXED_POINT
 
-    uint64_t anomaly_end_ms = ei_read_timer_ms();
+    result->timing.anomaly_ns = ei_read_timer_ns() - anomaly_start_ns;
+    result->timing.anomaly_us = result->timing.anomaly_ns / 1000;
+    result->timing.anomaly = (int)(result->timing.anomaly_us / 1000);
 
     if (debug) {
-        ei_printf("Anomaly score (time: %d ms.): ", static_cast<int>(anomaly_end_ms - anomaly_start_ms));
+        ei_printf("Anomaly score (time: %d ms.): ", result->timing.anomaly);
         ei_printf_float(anomaly);
         ei_printf("\n");
     }
 
-    result->timing.anomaly = anomaly_end_ms - anomaly_start_ms;
-
     result->anomaly = anomaly;
 
     return EI_IMPULSE_OK;
 }
 
+/**
+ * Score every row of fmatrix (one window per row), same scores as inference_anomaly_invoke.
+ * The rows are scored together against the clusters (get_min_distance_to_cluster_batch),
+ * or one by one with EI_CLASSIFIER_ANOMALY_FIXED_POINT. Batches never use the ball tree of
+ * EI_CLASSIFIER_ANOMALY_TREE, the batch kernel is faster than the tree per window.
+ * The anomaly time is split evenly over the results.
+ */
+EI_IMPULSE_ERROR inference_anomaly_invoke_batch(const ei_impulse_t *impulse,
+                                                ei::matrix_t *fmatrix,
+                                                ei_impulse_result_t *results,
+                                                bool debug = false)
+{
+    uint64_t anomaly_start_ns = ei_read_timer_ns();
+
+    const size_t count = fmatrix->rows;
+
+#if EI_CLASSIFIER_ANOMALY_FIXED_POINT == 0
+    const ei_classifier_anom_clusters_soa_t *soa = get_anomaly_clusters_soa();
+#endif
+
+    ei::matrix_t inputs(count, EI_CLASSIFIER_ANOM_AXIS_SIZE);
+    ei::matrix_t anomaly(1, count);
+    if (!inputs.buffer || !anomaly.buffer) {
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+
+    for (size_t row = 0; row < count; row++) {
+        const float *features = fmatrix->get_row_ptr(row);
+        float *input = inputs.get_row_ptr(row);
+        for (size_t ix = 0; ix < EI_CLASSIFIER_ANOM_AXIS_SIZE; ix++) {
+            input[ix] = features[EI_CLASSIFIER_ANOM_AXIS[ix]];
+        }
+#if EI_CLASSIFIER_ANOMALY_FIXED_POINT != 0
+        int16_t input_fixed[EI_CLASSIFIER_ANOM_AXIS_SIZE];
+        standard_scaler_fixed(input, &ei_classifier_anom_clusters_fixed, input_fixed);
+        anomaly.buffer[row] = get_min_distance_to_cluster_fixed(input_fixed, &ei_classifier_anom_clusters_fixed);
+#else
+        standard_scaler(input, ei_classifier_anom_scale, ei_classifier_anom_mean, EI_CLASSIFIER_ANOM_AXIS_SIZE);
+#endif
+    }
+#if EI_CLASSIFIER_ANOMALY_FIXED_POINT == 0
+    get_min_distance_to_cluster_batch(inputs.buffer, count, soa, anomaly.buffer);
+#endif
+
+    uint64_t anomaly_ns = (ei_read_timer_ns() - anomaly_start_ns) / (count > 0 ? count : 1);
+
+    for (size_t row = 0; row < count; row++) {
+        ei_impulse_result_t *result = &results[row];
+        result->timing.anomaly_ns = anomaly_ns;
+        result->timing.anomaly_us = result->timing.anomaly_ns / 1000;
+        result->timing.anomaly = (int)(result->timing.anomaly_us / 1000);
+
+        if (debug) {
+            ei_printf("Anomaly score (time: %d ms.): ", result->timing.anomaly);
+            ei_printf_float(anomaly.buffer[row]);
+            ei_printf("\n");
+        }
+
+        result->anomaly = anomaly.buffer[row];
+    }
+
+    return EI_IMPULSE_OK;
+}
+
 #endif //#if (EI_CLASSIFIER_HAS_ANOMALY == 1)
 #endif // _EDGE_IMPULSE_INFERENCING_ANOMALY_H_
@@ -538,13 +538,13 @@ EI_IMPULSE_ERROR drpai_run_yolov5_postprocessing(
         }
     }
 
-    uint64_t ctx_start_us = ei_read_timer_us();
+    uint64_t ctx_start_ns = ei_read_timer_ns();
 
     interpreter->Invoke();
 
-    uint64_t ctx_end_us = ei_read_timer_us();
+    uint64_t ctx_end_ns = ei_read_timer_ns();
 
-    EI_LOGD("Invoke took %d ms.\n", (int)((ctx_end_us - ctx_start_us) / 1000));
+    EI_LOGD("Invoke took %d ms.\n", (int)((ctx_end_ns - ctx_start_ns) / 1000000));
 
     float* out_data = interpreter->typed_output_tensor<float>(0);
 
@@ -580,8 +580,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     bool debug = false)
 {
     static bool first_run = true;
-    uint64_t ctx_start_us;
-    uint64_t dsp_start_us = ei_read_timer_us();
+    uint64_t ctx_start_ns;
+    uint64_t dsp_start_ns = ei_read_timer_ns();
 
     if (first_run) {
         // map memory regions to the DRP-AI UDMA. This is required for passing data
@@ -626,7 +626,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return EI_IMPULSE_CANCELED;
     }
 
-    result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp_ns = ei_read_timer_ns() - dsp_start_ns;
+    result->timing.dsp_us = result->timing.dsp_ns / 1000;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
     if (debug) {
       ei_printf("Features (%d ms.): ", result->timing.dsp);
@@ -636,7 +637,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
       ei_printf("\n");
     }
 
-    ctx_start_us = ei_read_timer_us();
+    ctx_start_ns = ei_read_timer_ns();
 
     // Run DRP-AI inference, a static buffer is used to store the raw output
     // results
@@ -721,7 +722,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return fill_res;
     }
 
-    result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+    result->timing.classification_ns = ei_read_timer_ns() - ctx_start_ns;
+    result->timing.classification_us = result->timing.classification_ns / 1000;
     result->timing.classification = (int)(result->timing.classification_us / 1000);
     return EI_IMPULSE_OK;
 }
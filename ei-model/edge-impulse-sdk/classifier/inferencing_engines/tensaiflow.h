@@ -73,7 +73,7 @@ EI_IMPULSE_ERROR run_nn_inference(
         return EI_IMPULSE_UNSUPPORTED_INFERENCING_ENGINE;
     }
 
-    uint64_t ctx_start_us = ei_read_timer_us();
+    uint64_t ctx_start_ns = ei_read_timer_ns();
     uint32_t time, cycles;
 
     /* Run tensaiflow inference */
@@ -81,7 +81,8 @@ EI_IMPULSE_ERROR run_nn_inference(
 
     // Inference results returned by post_process() and copied into infer_results
 
-    result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+    result->timing.classification_ns = ei_read_timer_ns() - ctx_start_ns;
+    result->timing.classification_us = result->timing.classification_ns / 1000;
     result->timing.classification = (int)(result->timing.classification_us / 1000);
 
     for (uint32_t ix = 0; ix < impulse->label_count; ix++) {
@@ -115,8 +116,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     bool debug = false)
 {
 
-    uint64_t ctx_start_us;
-    uint64_t dsp_start_us = ei_read_timer_us();
+    uint64_t ctx_start_ns;
+    uint64_t dsp_start_ns = ei_read_timer_ns();
 
     ei::matrix_i8_t features_matrix(1, impulse->nn_input_frame_size);
     processed_features = (int8_t *) features_matrix.buffer;
@@ -132,7 +133,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return EI_IMPULSE_CANCELED;
     }
 
-    result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp_ns = ei_read_timer_ns() - dsp_start_ns;
+    result->timing.dsp_us = result->timing.dsp_ns / 1000;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
     if (debug) {
@@ -145,14 +147,15 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     }
 
     uint32_t time, cycles;
-    ctx_start_us = ei_read_timer_us();
+    ctx_start_ns = ei_read_timer_ns();
 
     /* Run tensaiflow inference */
     infer((const void *)impulse, &time, &cycles);
 
     // Inference results returned by post_process() and copied into infer_results
 
-    result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+    result->timing.classification_ns = ei_read_timer_ns() - ctx_start_ns;
+    result->timing.classification_us = result->timing.classification_ns / 1000;
     result->timing.classification = (int)(result->timing.classification_us / 1000);
 
     for (uint32_t ix = 0; ix < impulse->label_count; ix++) {
@@ -101,13 +101,14 @@ EI_IMPULSE_ERROR run_nn_inference(
         ei_trt_handle = libeitrt::create_EiTrt(model_file_name, debug);
     }
 
-    uint64_t ctx_start_us = ei_read_timer_us();
+    uint64_t ctx_start_ns = ei_read_timer_ns();
 
     libeitrt::infer(ei_trt_handle, fmatrix->buffer, out_data, impulse->tflite_output_features_count);
 
-    uint64_t ctx_end_us = ei_read_timer_us();
+    uint64_t ctx_end_ns = ei_read_timer_ns();
 
-    result->timing.classification_us = ctx_end_us - ctx_start_us;
+    result->timing.classification_ns = ctx_end_ns - ctx_start_ns;
+    result->timing.classification_us = result->timing.classification_ns / 1000;
     result->timing.classification = (int)(result->timing.classification_us / 1000);
 
     EI_IMPULSE_ERROR fill_res = EI_IMPULSE_OK;
@@ -31,6 +31,7 @@
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "edge-impulse-sdk/classifier/ei_fill_result_struct.h"
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
 
 #if defined(EI_CLASSIFIER_ENABLE_DETECTION_POSTPROCESS_OP)
 namespace tflite {
@@ -50,25 +51,97 @@ static TfLiteRegistration post_process_op = tflite::ops::micro::Register_TFLite_
 
 #endif // defined(EI_CLASSIFIER_ENABLE_DETECTION_POSTPROCESS_OP)
 
+static bool tflite_session_initialized = false;
+// number of open batches (see inference_tflite_batch_begin), the model is kept while > 0
+static uint32_t tflite_session_batch_count = 0;
+
+/**
+ * Initialize the compiled model. With EI_CLASSIFIER_PERSISTENT_SESSION enabled, or
+ * while a batch is open, this only allocates the arena and prepares the kernels on
+ * the first call.
+ *
+ * @return  kTfLiteOk if successful
+ */
+static TfLiteStatus inference_tflite_model_init() {
+    if (tflite_session_initialized) {
+        return kTfLiteOk;
+    }
+
+    TfLiteStatus init_status = trained_model_init(ei_aligned_calloc);
+    if (init_status == kTfLiteOk) {
+        tflite_session_initialized = true;
+    }
+    return init_status;
+}
+
+/**
+ * Release the compiled model after an inference. This is a no-op when
+ * EI_CLASSIFIER_PERSISTENT_SESSION is enabled (see inference_tflite_session_deinit()),
+ * or while a batch is open.
+ */
+static void inference_tflite_model_release() {
+#if EI_CLASSIFIER_PERSISTENT_SESSION == 0
+    if (tflite_session_batch_count > 0 || !tflite_session_initialized) {
+        return;
+    }
+
+    trained_model_reset(ei_aligned_free);
+    tflite_session_initialized = false;
+#endif // EI_CLASSIFIER_PERSISTENT_SESSION == 0
+}
+
+/**
+ * Keep the model initialized between inferences until inference_tflite_batch_end(),
+ * so a batch of windows only pays for the arena allocation and kernel setup once.
+ */
+__attribute__((unused)) static void inference_tflite_batch_begin() {
+    tflite_session_batch_count++;
+}
+
+/**
+ * Close a batch opened with inference_tflite_batch_begin(), releases the model when
+ * this was the last open batch.
+ */
+__attribute__((unused)) static void inference_tflite_batch_end() {
+    if (tflite_session_batch_count > 0) {
+        tflite_session_batch_count--;
+    }
+    inference_tflite_model_release();
+}
+
+#if EI_CLASSIFIER_PERSISTENT_SESSION == 1
+/**
+ * Tear down the persistent model session (frees the arena and any overflow buffers).
+ * The next inference will initialize the model again.
+ */
+__attribute__((unused)) static void inference_tflite_session_deinit() {
+    if (!tflite_session_initialized) {
+        return;
+    }
+
+    trained_model_reset(ei_aligned_free);
+    tflite_session_initialized = false;
+}
+#endif // EI_CLASSIFIER_PERSISTENT_SESSION == 1
 
 /**
  * Setup the TFLite runtime
  *
- * @param      ctx_start_us       Pointer to the start time
+ * @param      ctx_start_ns       Pointer to the start time
  * @param      input              Pointer to input tensor
  * @param      output             Pointer to output tensor
  * @param      micro_tensor_arena Pointer to the arena that will be allocated
  *
  * @return  EI_IMPULSE_OK if successful
  */
-static EI_IMPULSE_ERROR inference_tflite_setup(const ei_impulse_t *impulse, uint64_t *ctx_start_us, TfLiteTensor** input, TfLiteTensor** output,
+static EI_IMPULSE_ERROR inference_tflite_setup(const ei_impulse_t *impulse, uint64_t *ctx_start_ns, TfLiteTensor** input, TfLiteTensor** output,
     TfLiteTensor** output_labels,
     TfLiteTensor** output_scores,
     ei_unique_ptr_t& p_tensor_arena) {
 
-    *ctx_start_us = ei_read_timer_us();
+    *ctx_start_ns = ei_read_timer_ns();
 
-    TfLiteStatus init_status = trained_model_init(ei_aligned_calloc);
+    TfLiteStatus init_status = inference_tflite_model_init();
     if (init_status != kTfLiteOk) {
         ei_printf("Failed to allocate TFLite arena (error code %d)\n", init_status);
         return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
@@ -106,40 +179,23 @@ static EI_IMPULSE_ERROR inference_tflite_setup(const ei_impulse_t *impulse, uint
 }
 
 /**
- * Run TFLite model
+ * Fill the result struct from the output tensor(s) of the model
  *
- * @param   ctx_start_us    Start time of the setup function (see above)
  * @param   output          Output tensor
- * @param   interpreter     TFLite interpreter (non-compiled models)
- * @param   tensor_arena    Allocated arena (will be freed)
+ * @param   labels_tensor   Labels tensor (SSD models)
+ * @param   scores_tensor   Scores tensor (SSD models)
  * @param   result          Struct for results
  * @param   debug           Whether to print debug info
  *
  * @return  EI_IMPULSE_OK if successful
  */
-static EI_IMPULSE_ERROR inference_tflite_run(const ei_impulse_t *impulse,
-    uint64_t ctx_start_us,
+static EI_IMPULSE_ERROR inference_tflite_fill_result(const ei_impulse_t *impulse,
     TfLiteTensor* output,
     TfLiteTensor* labels_tensor,
     TfLiteTensor* scores_tensor,
-    uint8_t* tensor_arena,
     ei_impulse_result_t *result,
     bool debug) {
 
-    if(trained_model_invoke() != kTfLiteOk) {
-        return EI_IMPULSE_TFLITE_ERROR;
-    }
-
-    uint64_t ctx_end_us = ei_read_timer_us();
-
-    result->timing.classification_us = ctx_end_us - ctx_start_us;
-    result->timing.classification = (int)(result->timing.classification_us / 1000);
-
-    // Read the predicted y value from the model's output tensor
-    if (debug) {
-        ei_printf("Predictions (time: %d ms.):\n", result->timing.classification);
-    }
-
     EI_IMPULSE_ERROR fill_res = EI_IMPULSE_OK;
 
     if (impulse->object_detection) {
@@ -193,7 +249,48 @@ static EI_IMPULSE_ERROR inference_tflite_run(const ei_impulse_t *impulse,
         }
     }
 
-    trained_model_reset(ei_aligned_free);
+    return fill_res;
+}
+
+/**
+ * Run TFLite model
+ *
+ * @param   ctx_start_ns    Start time of the setup function (see above)
+ * @param   output          Output tensor
+ * @param   interpreter     TFLite interpreter (non-compiled models)
+ * @param   tensor_arena    Allocated arena (will be freed)
+ * @param   result          Struct for results
+ * @param   debug           Whether to print debug info
+ *
+ * @return  EI_IMPULSE_OK if successful
+ */
+static EI_IMPULSE_ERROR inference_tflite_run(const ei_impulse_t *impulse,
+    uint64_t ctx_start_ns,
+    TfLiteTensor* output,
+    TfLiteTensor* labels_tensor,
+    TfLiteTensor* scores_tensor,
+    uint8_t* tensor_arena,
+    ei_impulse_result_t *result,
+    bool debug) {
+
+    if(trained_model_invoke() != kTfLiteOk) {
+        return EI_IMPULSE_TFLITE_ERROR;
+    }
+
+    uint64_t ctx_end_ns = ei_read_timer_ns();
+
+    result->timing.classification_ns = ctx_end_ns - ctx_start_ns;
+    result->timing.classification_us = result->timing.classification_ns / 1000;
+    result->timing.classification = (int)(result->timing.classification_us / 1000);
+
+    // Read the predicted y value from the model's output tensor
+    if (debug) {
+        ei_printf("Predictions (time: %d ms.):\n", result->timing.classification);
+    }
+
+    EI_IMPULSE_ERROR fill_res = inference_tflite_fill_result(impulse, output, labels_tensor, scores_tensor, result, debug);
+
+    inference_tflite_model_release();
 
     if (fill_res != EI_IMPULSE_OK) {
         return fill_res;
@@ -207,6 +304,47 @@ static EI_IMPULSE_ERROR inference_tflite_run(const ei_impulse_t *impulse,
 }
 
 
+/**
+ * Copy (and quantize, if needed) the features into the input tensor
+ *
+ * @param   input           Input tensor
+ * @param   fmatrix         Processed matrix
+ *
+ * @return  EI_IMPULSE_OK if successful
+ */
+static EI_IMPULSE_ERROR inference_tflite_fill_input(const ei_impulse_t *impulse,
+    TfLiteTensor* input,
+    ei::matrix_t *fmatrix) {
+
+    switch (input->type) {
+        case kTfLiteFloat32: {
+            for (size_t ix = 0; ix < fmatrix->rows * fmatrix->cols; ix++) {
+                input->data.f[ix] = fmatrix->buffer[ix];
+            }
+            break;
+        }
+        case kTfLiteInt8: {
+            for (size_t ix = 0; ix < fmatrix->rows * fmatrix->cols; ix++) {
+                float pixel = (float)fmatrix->buffer[ix];
+                input->data.int8[ix] = static_cast<int8_t>(round(pixel / input->params.scale) + input->params.zero_point);
+            }
+            break;
+        }
+        case kTfLiteUInt8: {
+            for (size_t ix = 0; ix < fmatrix->rows * fmatrix->cols; ix++) {
+                float pixel = (float)fmatrix->buffer[ix];
+                input->data.uint8[ix] = static_cast<uint8_t>((pixel / impulse->tflite_input_scale) + impulse->tflite_input_zeropoint);
+            }
+        }
+        default: {
+            ei_printf("ERR: Cannot handle input type (%d)\n", input->type);
+            return EI_IMPULSE_INPUT_TENSOR_WAS_NULL;
+        }
+    }
+
+    return EI_IMPULSE_OK;
+}
+
 /**
  * @brief      Do neural network inferencing over the processed feature matrix
  *
@@ -227,11 +365,11 @@ EI_IMPULSE_ERROR run_nn_inference(
     TfLiteTensor* output_scores;
     TfLiteTensor* output_labels;
 
-    uint64_t ctx_start_us = ei_read_timer_us();
+    uint64_t ctx_start_ns = ei_read_timer_ns();
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
 
     EI_IMPULSE_ERROR init_res = inference_tflite_setup(impulse,
-        &ctx_start_us,
+        &ctx_start_ns,
         &input, &output,
         &output_labels,
         &output_scores,
@@ -243,37 +381,17 @@ EI_IMPULSE_ERROR run_nn_inference(
 
     uint8_t* tensor_arena = static_cast<uint8_t*>(p_tensor_arena.get());
 
-    switch (input->type) {
-        case kTfLiteFloat32: {
-            for (size_t ix = 0; ix < fmatrix->rows * fmatrix->cols; ix++) {
-                input->data.f[ix] = fmatrix->buffer[ix];
-            }
-            break;
-        }
-        case kTfLiteInt8: {
-            for (size_t ix = 0; ix < fmatrix->rows * fmatrix->cols; ix++) {
-                float pixel = (float)fmatrix->buffer[ix];
-                input->data.int8[ix] = static_cast<int8_t>(round(pixel / input->params.scale) + input->params.zero_point);
-            }
-            break;
-        }
-        case kTfLiteUInt8: {
-            for (size_t ix = 0; ix < fmatrix->rows * fmatrix->cols; ix++) {
-                float pixel = (float)fmatrix->buffer[ix];
-                input->data.uint8[ix] = static_cast<uint8_t>((pixel / impulse->tflite_input_scale) + impulse->tflite_input_zeropoint);
-            }
-        }
-        default: {
-            ei_printf("ERR: Cannot handle input type (%d)\n", input->type);
-            return EI_IMPULSE_INPUT_TENSOR_WAS_NULL;
-        }
+    EI_IMPULSE_ERROR input_res = inference_tflite_fill_input(impulse, input, fmatrix);
+    if (input_res != EI_IMPULSE_OK) {
+        return input_res;
     }
 
-    EI_IMPULSE_ERROR run_res = inference_tflite_run(impulse, ctx_start_us,
+    EI_IMPULSE_ERROR run_res = inference_tflite_run(impulse, ctx_start_ns,
                                                     output, output_labels, output_scores,
                                                     tensor_arena, result, debug);
 
-    result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+    result->timing.classification_ns = ei_read_timer_ns() - ctx_start_ns;
+    result->timing.classification_us = result->timing.classification_ns / 1000;
 
     if (run_res != EI_IMPULSE_OK) {
         return run_res;
@@ -282,6 +400,58 @@ EI_IMPULSE_ERROR run_nn_inference(
     return EI_IMPULSE_OK;
 }
 
+/**
+ * @brief      Do neural network inferencing on a model instance created with
+ *             trained_model_create(). Every instance has its own arena and tensors,
+ *             so different threads can run inference at the same time, each on
+ *             their own instance.
+ *
+ * @param      ctx      Model instance
+ * @param      fmatrix  Processed matrix
+ * @param      result   Output classifier results
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+__attribute__((unused)) static EI_IMPULSE_ERROR run_nn_inference_ctx(
+    const ei_impulse_t *impulse,
+    trained_model_ctx_t *ctx,
+    ei::matrix_t *fmatrix,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    uint64_t ctx_start_ns = ei_read_timer_ns();
+
+    TfLiteTensor* input = trained_model_input(ctx, 0);
+    TfLiteTensor* output = trained_model_output(ctx, 0);
+    TfLiteTensor* output_scores = nullptr;
+    TfLiteTensor* output_labels = nullptr;
+
+    if (impulse->object_detection_last_layer == EI_CLASSIFIER_LAST_LAYER_SSD) {
+        output_scores = trained_model_output(ctx, impulse->tflite_output_score_tensor);
+        output_labels = trained_model_output(ctx, impulse->tflite_output_labels_tensor);
+    }
+
+    EI_IMPULSE_ERROR input_res = inference_tflite_fill_input(impulse, input, fmatrix);
+    if (input_res != EI_IMPULSE_OK) {
+        return input_res;
+    }
+
+    if (trained_model_invoke(ctx) != kTfLiteOk) {
+        return EI_IMPULSE_TFLITE_ERROR;
+    }
+
+    result->timing.classification_ns = ei_read_timer_ns() - ctx_start_ns;
+    result->timing.classification_us = result->timing.classification_ns / 1000;
+    result->timing.classification = (int)(result->timing.classification_us / 1000);
+
+    if (debug) {
+        ei_printf("Predictions (time: %d ms.):\n", result->timing.classification);
+    }
+
+    return inference_tflite_fill_result(impulse, output, output_labels, output_scores, result, debug);
+}
+
 #if EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1
 /**
  * Special function to run the classifier on images, only works on TFLite models (either interpreter or EON or for tensaiflow)
@@ -296,7 +466,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
 
     memset(result, 0, sizeof(ei_impulse_result_t));
 
-    uint64_t ctx_start_us;
+    uint64_t ctx_start_ns;
     TfLiteTensor* input;
     TfLiteTensor* output;
     TfLiteTensor* output_scores;
@@ -305,7 +475,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
 
     EI_IMPULSE_ERROR init_res = inference_tflite_setup(impulse,
-        &ctx_start_us, &input, &output,
+        &ctx_start_ns, &input, &output,
         &output_labels,
         &output_scores,
         p_tensor_arena);
@@ -317,7 +487,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
     }
 
-    uint64_t dsp_start_us = ei_read_timer_us();
+    uint64_t dsp_start_ns = ei_read_timer_ns();
 
     // features matrix maps around the input tensor to not allocate any memory
     ei::matrix_i8_t features_matrix(1, impulse->nn_input_frame_size, input->data.int8);
@@ -333,7 +503,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return EI_IMPULSE_CANCELED;
     }
 
-    result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp_ns = ei_read_timer_ns() - dsp_start_ns;
+    result->timing.dsp_us = result->timing.dsp_ns / 1000;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
     if (debug) {
@@ -345,10 +516,10 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         ei_printf("\n");
     }
 
-    ctx_start_us = ei_read_timer_us();
+    ctx_start_ns = ei_read_timer_ns();
 
     EI_IMPULSE_ERROR run_res = inference_tflite_run(impulse,
-        ctx_start_us,
+        ctx_start_ns,
         output,
         output_labels,
         output_scores,
@@ -359,7 +530,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return run_res;
     }
 
-    result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+    result->timing.classification_ns = ei_read_timer_ns() - ctx_start_ns;
+    result->timing.classification_us = result->timing.classification_ns / 1000;
 
     return EI_IMPULSE_OK;
 }
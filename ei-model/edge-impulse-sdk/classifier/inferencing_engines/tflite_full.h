@@ -106,13 +106,14 @@ extern "C" EI_IMPULSE_ERROR run_nn_inference(
     }
     }
 
-    uint64_t ctx_start_us = ei_read_timer_us();
+    uint64_t ctx_start_ns = ei_read_timer_ns();
 
     interpreter->Invoke();
 
-    uint64_t ctx_end_us = ei_read_timer_us();
+    uint64_t ctx_end_ns = ei_read_timer_ns();
 
-    result->timing.classification_us = ctx_end_us - ctx_start_us;
+    result->timing.classification_ns = ctx_end_ns - ctx_start_ns;
+    result->timing.classification_us = result->timing.classification_ns / 1000;
     result->timing.classification = (int)(result->timing.classification_us / 1000);
 
 #if EI_CLASSIFIER_TFLITE_OUTPUT_QUANTIZED == 1
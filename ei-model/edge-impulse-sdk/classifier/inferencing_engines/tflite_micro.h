@@ -33,6 +33,7 @@
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "edge-impulse-sdk/classifier/ei_fill_result_struct.h"
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
 
 #if defined(EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER) && EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER == 1
 #include "tflite-model/tflite-resolver.h"
@@ -70,10 +71,134 @@ static TfLiteRegistration post_process_op = tflite::ops::micro::Register_TFLite_
 #endif
 #endif
 
+#if EI_CLASSIFIER_PERSISTENT_SESSION == 1
+typedef struct {
+    uint32_t project_id;
+    uint32_t deploy_version;
+    tflite::MicroInterpreter *interpreter;
+    uint8_t *tensor_arena;
+} ei_tflite_session_t;
+
+static ei_tflite_session_t tflite_session = { 0, 0, nullptr, nullptr };
+
+/**
+ * Op resolver used by the persistent session. The interpreter keeps a reference
+ * to the resolver, so it needs to live as long as the session does.
+ */
+static tflite::MicroOpResolver* inference_tflite_session_resolver() {
+    static tflite::MicroOpResolver *session_resolver = nullptr;
+
+    if (!session_resolver) {
+#ifdef EI_TFLITE_RESOLVER
+        EI_TFLITE_RESOLVER
+#else
+        tflite::AllOpsResolver resolver;
+#endif
+#if defined(EI_CLASSIFIER_ENABLE_DETECTION_POSTPROCESS_OP)
+        resolver.AddCustom("TFLite_Detection_PostProcess", &post_process_op);
+#endif
+        // the resolver above might be a local, so keep our own copy around
+        session_resolver = new decltype(resolver)(resolver);
+    }
+
+    return session_resolver;
+}
+
+/**
+ * Tear down the persistent interpreter and free its arena.
+ * The next inference will build the interpreter again.
+ */
+__attribute__((unused)) static void inference_tflite_session_deinit() {
+    if (tflite_session.interpreter) {
+        delete tflite_session.interpreter;
+    }
+#ifndef EI_CLASSIFIER_ALLOCATION_STATIC
+    if (tflite_session.tensor_arena) {
+        ei_aligned_free(tflite_session.tensor_arena);
+    }
+#endif
+
+    tflite_session.project_id = 0;
+    tflite_session.deploy_version = 0;
+    tflite_session.interpreter = nullptr;
+    tflite_session.tensor_arena = nullptr;
+}
+
+/**
+ * Get the persistent interpreter for this impulse. The interpreter (model parsing,
+ * op resolving and memory planning) is only built on the first call, or when
+ * a different impulse (project ID / deploy version) is passed in.
+ *
+ * @param      micro_interpreter  Pointer to the cached interpreter
+ * @param      p_tensor_arena     Non-owning pointer to the cached arena
+ *
+ * @return  EI_IMPULSE_OK if successful
+ */
+static EI_IMPULSE_ERROR inference_tflite_session_get(const ei_impulse_t *impulse,
+    tflite::MicroInterpreter** micro_interpreter,
+    ei_unique_ptr_t& p_tensor_arena) {
+
+    if (tflite_session.interpreter &&
+        tflite_session.project_id == impulse->project_id &&
+        tflite_session.deploy_version == impulse->deploy_version) {
+
+        // same as a fresh interpreter, don't carry state over between inferences
+        if (tflite_session.interpreter->ResetVariableTensors() != kTfLiteOk) {
+            error_reporter->Report("ResetVariableTensors() failed");
+            return EI_IMPULSE_TFLITE_ERROR;
+        }
+
+        *micro_interpreter = tflite_session.interpreter;
+        p_tensor_arena = ei_unique_ptr_t(tflite_session.tensor_arena, [](void*){});
+        return EI_IMPULSE_OK;
+    }
+
+    inference_tflite_session_deinit();
+
+#ifdef EI_CLASSIFIER_ALLOCATION_STATIC
+    static uint8_t tensor_arena[EI_CLASSIFIER_TFLITE_ARENA_SIZE] ALIGN(16);
+#else
+    uint8_t *tensor_arena = (uint8_t*)ei_aligned_calloc(16, impulse->tflite_arena_size);
+    if (tensor_arena == NULL) {
+        ei_printf("Failed to allocate TFLite arena (%d bytes)\n", impulse->tflite_arena_size);
+        return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+    }
+#endif
+    tflite_session.tensor_arena = tensor_arena;
+
+    const tflite::Model* model = tflite::GetModel(impulse->model_arr);
+    if (model->version() != TFLITE_SCHEMA_VERSION) {
+        error_reporter->Report(
+            "Model provided is schema version %d not equal "
+            "to supported version %d.",
+            model->version(), TFLITE_SCHEMA_VERSION);
+        inference_tflite_session_deinit();
+        return EI_IMPULSE_TFLITE_ERROR;
+    }
+
+    tflite_session.interpreter = new tflite::MicroInterpreter(
+        model, *inference_tflite_session_resolver(), tensor_arena, impulse->tflite_arena_size, error_reporter);
+
+    TfLiteStatus allocate_status = tflite_session.interpreter->AllocateTensors();
+    if (allocate_status != kTfLiteOk) {
+        error_reporter->Report("AllocateTensors() failed");
+        inference_tflite_session_deinit();
+        return EI_IMPULSE_TFLITE_ERROR;
+    }
+
+    tflite_session.project_id = impulse->project_id;
+    tflite_session.deploy_version = impulse->deploy_version;
+
+    *micro_interpreter = tflite_session.interpreter;
+    p_tensor_arena = ei_unique_ptr_t(tflite_session.tensor_arena, [](void*){});
+    return EI_IMPULSE_OK;
+}
+#endif // EI_CLASSIFIER_PERSISTENT_SESSION == 1
+
 /**
  * Setup the TFLite runtime
  *
- * @param      ctx_start_us       Pointer to the start time
+ * @param      ctx_start_ns       Pointer to the start time
  * @param      input              Pointer to input tensor
  * @param      output             Pointer to output tensor
  * @param      micro_interpreter  Pointer to interpreter (for non-compiled models)
@@ -81,14 +206,30 @@ static TfLiteRegistration post_process_op = tflite::ops::micro::Register_TFLite_
  *
  * @return  EI_IMPULSE_OK if successful
  */
-static EI_IMPULSE_ERROR inference_tflite_setup(const ei_impulse_t *impulse, uint64_t *ctx_start_us, TfLiteTensor** input, TfLiteTensor** output,
+static EI_IMPULSE_ERROR inference_tflite_setup(const ei_impulse_t *impulse, uint64_t *ctx_start_ns, TfLiteTensor** input, TfLiteTensor** output,
     TfLiteTensor** output_labels,
     TfLiteTensor** output_scores,
     tflite::MicroInterpreter** micro_interpreter,
     ei_unique_ptr_t& p_tensor_arena) {
 
-    *ctx_start_us = ei_read_timer_us();
+    *ctx_start_ns = ei_read_timer_ns();
+
+    static bool tflite_first_run = true;
+    static uint32_t project_id = 0;
+
+    if (project_id != impulse->project_id) {
+        tflite_first_run = true;
+        project_id = impulse->project_id;
+    }
 
+#if EI_CLASSIFIER_PERSISTENT_SESSION == 1
+    EI_IMPULSE_ERROR session_res = inference_tflite_session_get(impulse, micro_interpreter, p_tensor_arena);
+    if (session_res != EI_IMPULSE_OK) {
+        return session_res;
+    }
+
+    tflite::MicroInterpreter *interpreter = *micro_interpreter;
+#else
 #ifdef EI_CLASSIFIER_ALLOCATION_STATIC
     // Assign a no-op lambda to the "free" function in case of static arena
     static uint8_t tensor_arena[EI_CLASSIFIER_TFLITE_ARENA_SIZE] ALIGN(16);
@@ -103,14 +244,6 @@ static EI_IMPULSE_ERROR inference_tflite_setup(const ei_impulse_t *impulse, uint
     p_tensor_arena = ei_unique_ptr_t(tensor_arena, ei_aligned_free);
 #endif
 
-    static bool tflite_first_run = true;
-    static uint32_t project_id = 0;
-
-    if (project_id != impulse->project_id) {
-        tflite_first_run = true;
-        project_id = impulse->project_id;
-    }
-
     static const tflite::Model* model = nullptr;
 
     // ======
@@ -152,6 +285,7 @@ static EI_IMPULSE_ERROR inference_tflite_setup(const ei_impulse_t *impulse, uint
         error_reporter->Report("AllocateTensors() failed");
         return EI_IMPULSE_TFLITE_ERROR;
     }
+#endif // EI_CLASSIFIER_PERSISTENT_SESSION == 1
 
     // Obtain pointers to the model's input and output tensors.
     *input = interpreter->input(0);
@@ -187,17 +321,19 @@ static EI_IMPULSE_ERROR inference_tflite_setup(const ei_impulse_t *impulse, uint
 /**
  * Run TFLite model
  *
- * @param   ctx_start_us    Start time of the setup function (see above)
+ * @param   ctx_start_ns    Start time of the setup function (see above)
  * @param   output          Output tensor
  * @param   interpreter     TFLite interpreter (non-compiled models)
  * @param   tensor_arena    Allocated arena (will be freed)
  * @param   result          Struct for results
  * @param   debug           Whether to print debug info
  *
+ * The interpreter is deleted after invoking, unless EI_CLASSIFIER_PERSISTENT_SESSION is enabled.
+ *
  * @return  EI_IMPULSE_OK if successful
  */
 static EI_IMPULSE_ERROR inference_tflite_run(const ei_impulse_t *impulse,
-    uint64_t ctx_start_us,
+    uint64_t ctx_start_ns,
     TfLiteTensor* output,
     TfLiteTensor* labels_tensor,
     TfLiteTensor* scores_tensor,
@@ -212,11 +348,14 @@ static EI_IMPULSE_ERROR inference_tflite_run(const ei_impulse_t *impulse,
         error_reporter->Report("Invoke failed (%d)\n", invoke_status);
         return EI_IMPULSE_TFLITE_ERROR;
     }
+#if EI_CLASSIFIER_PERSISTENT_SESSION == 0
     delete interpreter;
+#endif
 
-    uint64_t ctx_end_us = ei_read_timer_us();
+    uint64_t ctx_end_ns = ei_read_timer_ns();
 
-    result->timing.classification_us = ctx_end_us - ctx_start_us;
+    result->timing.classification_ns = ctx_end_ns - ctx_start_ns;
+    result->timing.classification_us = result->timing.classification_ns / 1000;
     result->timing.classification = (int)(result->timing.classification_us / 1000);
 
     // Read the predicted y value from the model's output tensor
@@ -307,12 +446,12 @@ EI_IMPULSE_ERROR run_nn_inference(
     TfLiteTensor* output;
     TfLiteTensor* output_scores;
     TfLiteTensor* output_labels;
-    uint64_t ctx_start_us = ei_read_timer_us();
+    uint64_t ctx_start_ns = ei_read_timer_ns();
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
 
     tflite::MicroInterpreter* interpreter;
     EI_IMPULSE_ERROR init_res = inference_tflite_setup(impulse,
-        &ctx_start_us,
+        &ctx_start_ns,
         &input, &output,
         &output_labels,
         &output_scores,
@@ -351,13 +490,14 @@ EI_IMPULSE_ERROR run_nn_inference(
     }
 
     EI_IMPULSE_ERROR run_res = inference_tflite_run(impulse,
-        ctx_start_us,
+        ctx_start_ns,
         output,
         output_labels,
         output_scores,
         interpreter, tensor_arena, result, debug);
 
-    result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+    result->timing.classification_ns = ei_read_timer_ns() - ctx_start_ns;
+    result->timing.classification_us = result->timing.classification_ns / 1000;
 
     if (run_res != EI_IMPULSE_OK) {
         return run_res;
@@ -380,7 +520,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
 {
     memset(result, 0, sizeof(ei_impulse_result_t));
 
-    uint64_t ctx_start_us;
+    uint64_t ctx_start_ns;
     TfLiteTensor* input;
     TfLiteTensor* output;
     TfLiteTensor* output_scores;
@@ -389,7 +529,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
 
     tflite::MicroInterpreter* interpreter;
     EI_IMPULSE_ERROR init_res = inference_tflite_setup(impulse,
-        &ctx_start_us,
+        &ctx_start_ns,
         &input, &output,
         &output_labels,
         &output_scores,
@@ -404,7 +544,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
     }
 
-    uint64_t dsp_start_us = ei_read_timer_us();
+    uint64_t dsp_start_ns = ei_read_timer_ns();
 
     // features matrix maps around the input tensor to not allocate any memory
     ei::matrix_i8_t features_matrix(1, impulse->nn_input_frame_size, input->data.int8);
@@ -420,7 +560,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return EI_IMPULSE_CANCELED;
     }
 
-    result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp_ns = ei_read_timer_ns() - dsp_start_ns;
+    result->timing.dsp_us = result->timing.dsp_ns / 1000;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
     if (debug) {
@@ -432,10 +573,10 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         ei_printf("\n");
     }
 
-    ctx_start_us = ei_read_timer_us();
+    ctx_start_ns = ei_read_timer_ns();
 
     EI_IMPULSE_ERROR run_res = inference_tflite_run(impulse,
-        ctx_start_us,
+        ctx_start_ns,
         output,
         output_labels,
         output_scores,
@@ -447,7 +588,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return run_res;
     }
 
-    result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+    result->timing.classification_ns = ei_read_timer_ns() - ctx_start_ns;
+    result->timing.classification_us = result->timing.classification_ns / 1000;
 
     return EI_IMPULSE_OK;
 }
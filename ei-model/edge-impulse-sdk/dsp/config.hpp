@@ -89,5 +89,70 @@
 #define EIDSP_SIGNAL_C_FN_POINTER    0
 #endif // EIDSP_SIGNAL_C_FN_POINTER
 
+// number of FFT plans (keyed by FFT length) that numpy::rfft keeps around between calls,
+// so twiddle factors are only calculated once. Set to 0 to create the plan on every call.
+#ifndef EIDSP_FFT_PLAN_CACHE_SIZE
+#define EIDSP_FFT_PLAN_CACHE_SIZE    2
+#endif // EIDSP_FFT_PLAN_CACHE_SIZE
+
+// keep the DSP caches (FFT plans, mel filterbanks, Butterworth coefficients, wavelet workspace)
+// per thread, needed when DSP runs on several threads at once (e.g. ClassifierBatchPool).
+// A thread's caches are freed when it exits. On by default on hosts with an OS (Linux, macOS, Windows), off otherwise.
+// The default only depends on the target, so all translation units agree; if you override it,
+// set it for the whole project (a mismatch gives "TLS definition ... mismatches" link errors).
+#ifndef EIDSP_CACHE_THREAD_LOCAL
+#if defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+#define EIDSP_CACHE_THREAD_LOCAL    1
+#else
+#define EIDSP_CACHE_THREAD_LOCAL    0
+#endif
+#endif // EIDSP_CACHE_THREAD_LOCAL
+
+// compute the spectral analysis (v2) moments with 4 independent accumulators, so the
+// loops vectorize. Changes the summation order, so results differ in the last bits.
+#ifndef EIDSP_SPECTRAL_MOMENTS_VECTORIZED
+#define EIDSP_SPECTRAL_MOMENTS_VECTORIZED    0
+#endif // EIDSP_SPECTRAL_MOMENTS_VECTORIZED
+
+// number of mel filterbanks (keyed by filterbank config) that speechpy::feature::mfe keeps around
+// between calls, stored sparse (only the non-zero taps). Set to 0 to build the filterbank on every call.
+// Per thread if EIDSP_CACHE_THREAD_LOCAL is set.
+#ifndef EIDSP_MEL_FILTERBANK_CACHE_SIZE
+#define EIDSP_MEL_FILTERBANK_CACHE_SIZE    2
+#endif // EIDSP_MEL_FILTERBANK_CACHE_SIZE
+
+// keep the wavelet features workspace (filter and coefficient buffers for all levels) between
+// calls, it's only reallocated when the wavelet, level or signal length change. Set to 0 to
+// allocate it on every call. Per thread if EIDSP_CACHE_THREAD_LOCAL is set.
+#ifndef EIDSP_WAVELET_WORKSPACE_CACHE
+#define EIDSP_WAVELET_WORKSPACE_CACHE    1
+#endif // EIDSP_WAVELET_WORKSPACE_CACHE
+
+// highest Butterworth filter order that spectral::filters::butterworth_filter_t supports
+// (the coefficients and state are kept in fixed size arrays of order / 2 sections)
+#ifndef EIDSP_BUTTERWORTH_MAX_ORDER
+#define EIDSP_BUTTERWORTH_MAX_ORDER    8
+#endif // EIDSP_BUTTERWORTH_MAX_ORDER
+
+// filter all axes of a spectral analysis block together, in SIMD lanes (AVX, SSE2 or NEON,
+// plain C otherwise). Every section is calculated in float rather than double, so results
+// differ in the last bits.
+#ifndef EIDSP_BUTTERWORTH_VECTORIZED
+#define EIDSP_BUTTERWORTH_VECTORIZED    0
+#endif // EIDSP_BUTTERWORTH_VECTORIZED
+
+// calculate 4 wavelet (dwt) coefficients at once in SIMD lanes (SSE2 or NEON, plain C otherwise).
+// Every coefficient still sums its taps in order, so results match the scalar path. This is
+// verified on x86 only, so it's on by default there. On Arm, compilers that contract a * b + c
+// into FMA (GCC's default -ffp-contract=fast) round the scalar loops differently from the
+// NEON lanes, so features can differ in the last bits; set it to 1 to opt in.
+#ifndef EIDSP_WAVELET_VECTORIZED
+#if defined(__SSE2__) || defined(_M_X64)
+#define EIDSP_WAVELET_VECTORIZED    1
+#else
+#define EIDSP_WAVELET_VECTORIZED    0
+#endif
+#endif // EIDSP_WAVELET_VECTORIZED
+
 // clang-format on
 #endif // _EIDSP_CPP_CONFIG_H_
@@ -1193,6 +1193,16 @@ public:
     }
 
 
+    /**
+     * Size (in floats) of the scratch buffer that rfft and power_spectrum can use
+     * instead of allocating, so callers running many FFTs can allocate it once.
+     * @param n_fft FFT length
+     */
+    static size_t rfft_scratch_size(size_t n_fft) {
+        // the padded input + the complex output (n_fft / 2 + 1 values)
+        return n_fft + ((n_fft / 2) + 1) * 2;
+    }
+
     /**
      * Compute the one-dimensional discrete Fourier Transform for real input.
      * This function computes the one-dimensional n-point discrete Fourier Transform (DFT) of
@@ -1201,9 +1211,13 @@ public:
      * @param src_size Size of the source buffer
      * @param output Output buffer
      * @param output_size Size of the output buffer, should be n_fft / 2 + 1
+     * @param scratch Optional, rfft_scratch_size(n_fft) floats of scratch space.
+     *                If NULL the scratch space is allocated.
      * @returns 0 if OK
      */
-    static int rfft(const float *src, size_t src_size, float *output, size_t output_size, size_t n_fft) {
+    static int rfft(const float *src, size_t src_size, float *output, size_t output_size, size_t n_fft,
+        float *scratch = NULL)
+    {
         size_t n_fft_out_features = (n_fft / 2) + 1;
         if (output_size != n_fft_out_features) {
             EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
@@ -1215,20 +1229,22 @@ public:
         }
 
         // declare input and output arrays
-        EI_DSP_MATRIX(fft_input, 1, n_fft);
-        if (!fft_input.buffer) {
+        EI_DSP_MATRIX_B(scratch_matrix, 1, rfft_scratch_size(n_fft), scratch);
+        if (!scratch_matrix.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
+        float *fft_input = scratch_matrix.buffer;
+        float *fft_output = scratch_matrix.buffer + n_fft;
 
         // copy from src to fft_input
-        memcpy(fft_input.buffer, src, src_size * sizeof(float));
+        memcpy(fft_input, src, src_size * sizeof(float));
         // pad to the rigth with zeros
-        memset(fft_input.buffer + src_size, 0, (n_fft - src_size) * sizeof(kiss_fft_scalar));
+        memset(fft_input + src_size, 0, (n_fft - src_size) * sizeof(kiss_fft_scalar));
 
 #if EIDSP_USE_CMSIS_DSP
         if (n_fft != 32 && n_fft != 64 && n_fft != 128 && n_fft != 256 &&
             n_fft != 512 && n_fft != 1024 && n_fft != 2048 && n_fft != 4096) {
-            int ret = software_rfft(fft_input.buffer, output, n_fft, n_fft_out_features);
+            int ret = software_rfft(fft_input, output, n_fft, n_fft_out_features, (kiss_fft_cpx*)fft_output);
             if (ret != EIDSP_OK) {
                 EIDSP_ERR(ret);
             }
@@ -1236,32 +1252,27 @@ public:
         else {
             // hardware acceleration only works for the powers above...
             arm_rfft_fast_instance_f32 rfft_instance;
-            int status = cmsis_rfft_init_f32(&rfft_instance, n_fft);
+            int status = get_cmsis_rfft_plan(&rfft_instance, n_fft);
             if (status != ARM_MATH_SUCCESS) {
                 return status;
             }
 
-            EI_DSP_MATRIX(fft_output, 1, n_fft);
-            if (!fft_output.buffer) {
-                EIDSP_ERR(EIDSP_OUT_OF_MEM);
-            }
-
-            arm_rfft_fast_f32(&rfft_instance, fft_input.buffer, fft_output.buffer, 0);
+            arm_rfft_fast_f32(&rfft_instance, fft_input, fft_output, 0);
 
-            output[0] = fft_output.buffer[0];
-            output[n_fft_out_features - 1] = fft_output.buffer[1];
+            output[0] = fft_output[0];
+            output[n_fft_out_features - 1] = fft_output[1];
 
             size_t fft_output_buffer_ix = 2;
             for (size_t ix = 1; ix < n_fft_out_features - 1; ix += 1) {
                 float rms_result;
-                arm_rms_f32(fft_output.buffer + fft_output_buffer_ix, 2, &rms_result);
+                arm_rms_f32(fft_output + fft_output_buffer_ix, 2, &rms_result);
                 output[ix] = rms_result * sqrt(2);
 
                 fft_output_buffer_ix += 2;
             }
         }
 #else
-        int ret = software_rfft(fft_input.buffer, output, n_fft, n_fft_out_features);
+        int ret = software_rfft(fft_input, output, n_fft, n_fft_out_features, (kiss_fft_cpx*)fft_output);
         if (ret != EIDSP_OK) {
             EIDSP_ERR(ret);
         }
@@ -1321,7 +1332,7 @@ public:
         else {
             // hardware acceleration only works for the powers above...
             arm_rfft_fast_instance_f32 rfft_instance;
-            int status = cmsis_rfft_init_f32(&rfft_instance, n_fft);
+            int status = get_cmsis_rfft_plan(&rfft_instance, n_fft);
             if (status != ARM_MATH_SUCCESS) {
                 return status;
             }
@@ -1540,6 +1551,7 @@ public:
     static int signal_from_buffer(const float *data, size_t data_size, signal_t *signal)
     {
         signal->total_length = data_size;
+        signal->buffer = data;
 #ifdef __MBED__
         signal->get_data = mbed::callback(&numpy::signal_get_data, data);
 #else
@@ -1755,23 +1767,134 @@ public:
         return EIDSP_OK;
     }
 
-    static int software_rfft(float *fft_input, float *output, size_t n_fft, size_t n_fft_out_features) {
-        kiss_fft_cpx *fft_output = (kiss_fft_cpx*)ei_dsp_malloc(n_fft_out_features * sizeof(kiss_fft_cpx));
-        if (!fft_output) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+#if EIDSP_FFT_PLAN_CACHE_SIZE > 0
+    typedef struct {
+        size_t n_fft;
+        uint32_t last_used;
+        kiss_fftr_cfg kiss_cfg;
+        size_t kiss_cfg_mem_length;
+#if EIDSP_USE_CMSIS_DSP
+        bool cmsis_initialized;
+        arm_rfft_fast_instance_f32 cmsis_instance;
+#endif
+    } fft_plan_t;
+
+    typedef struct {
+        fft_plan_t plans[EIDSP_FFT_PLAN_CACHE_SIZE];
+        uint32_t tick;
+    } fft_plan_cache_t;
+
+    static fft_plan_cache_t *get_fft_plan_cache() {
+#if EIDSP_CACHE_THREAD_LOCAL == 1
+        // every thread has its own cache, the plans are freed when the thread exits
+        struct thread_cache_t {
+            fft_plan_cache_t cache;
+            ~thread_cache_t() { free_fft_plan_cache(&cache); }
+        };
+        static thread_local thread_cache_t thread_cache;
+        return &thread_cache.cache;
+#else
+        static fft_plan_cache_t cache = { };
+        return &cache;
+#endif
+    }
+
+    static void free_fft_plan_cache(fft_plan_cache_t *cache) {
+        for (size_t ix = 0; ix < EIDSP_FFT_PLAN_CACHE_SIZE; ix++) {
+            free_fft_plan(&cache->plans[ix]);
+        }
+        cache->tick = 0;
+    }
+
+    static void free_fft_plan(fft_plan_t *plan) {
+        if (plan->kiss_cfg) {
+            ei_dsp_free(plan->kiss_cfg, plan->kiss_cfg_mem_length);
+        }
+        memset(plan, 0, sizeof(fft_plan_t));
+    }
+
+    /**
+     * Find the cached plan for an FFT length. If there is none, the least recently
+     * used plan is freed and its slot is returned (empty) for n_fft.
+     */
+    static fft_plan_t *get_fft_plan_cache_entry(size_t n_fft) {
+        fft_plan_cache_t *cache = get_fft_plan_cache();
+        cache->tick++;
+
+        fft_plan_t *lru = &cache->plans[0];
+        for (size_t ix = 0; ix < EIDSP_FFT_PLAN_CACHE_SIZE; ix++) {
+            fft_plan_t *plan = &cache->plans[ix];
+            if (plan->n_fft == n_fft) {
+                plan->last_used = cache->tick;
+                return plan;
+            }
+            if (plan->last_used < lru->last_used) {
+                lru = plan;
+            }
         }
 
+        free_fft_plan(lru);
+        lru->n_fft = n_fft;
+        lru->last_used = cache->tick;
+        return lru;
+    }
+#endif // EIDSP_FFT_PLAN_CACHE_SIZE > 0
+
+    /**
+     * Free all cached FFT plans (see EIDSP_FFT_PLAN_CACHE_SIZE).
+     * Plans will be created again on the next rfft call.
+     */
+    static void clear_fft_plan_cache() {
+#if EIDSP_FFT_PLAN_CACHE_SIZE > 0
+        free_fft_plan_cache(get_fft_plan_cache());
+#endif
+    }
+
+    /**
+     * Get a kissfft real FFT plan, from the plan cache if enabled
+     * @param n_fft FFT length
+     * @param plan_mem_length Out: size of the plan if the caller owns it, 0 if it's owned by the cache
+     * @returns the plan, or NULL if out of memory. Pass to release_kiss_fftr_plan when done.
+     */
+    static kiss_fftr_cfg get_kiss_fftr_plan(size_t n_fft, size_t *plan_mem_length) {
+#if EIDSP_FFT_PLAN_CACHE_SIZE > 0
+        fft_plan_t *plan = get_fft_plan_cache_entry(n_fft);
+        if (!plan->kiss_cfg) {
+            plan->kiss_cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &plan->kiss_cfg_mem_length);
+            if (!plan->kiss_cfg) {
+                return NULL;
+            }
+            ei_dsp_register_alloc(plan->kiss_cfg_mem_length, plan->kiss_cfg);
+        }
+        *plan_mem_length = 0;
+        return plan->kiss_cfg;
+#else
+        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, plan_mem_length);
+        if (cfg) {
+            ei_dsp_register_alloc(*plan_mem_length, cfg);
+        }
+        return cfg;
+#endif
+    }
+
+    static void release_kiss_fftr_plan(kiss_fftr_cfg cfg, size_t plan_mem_length) {
+        // only plans that are not owned by the cache have a length
+        if (plan_mem_length > 0) {
+            ei_dsp_free(cfg, plan_mem_length);
+        }
+    }
+
+    static int software_rfft(float *fft_input, float *output, size_t n_fft, size_t n_fft_out_features,
+        kiss_fft_cpx *fft_output)
+    {
         size_t kiss_fftr_mem_length;
 
-        // create fftr context
-        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
+        // get fftr context
+        kiss_fftr_cfg cfg = get_kiss_fftr_plan(n_fft, &kiss_fftr_mem_length);
         if (!cfg) {
-            ei_dsp_free(fft_output, n_fft_out_features * sizeof(kiss_fft_cpx));
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
-
         // execute the rfft operation
         kiss_fftr(cfg, fft_input, fft_output);
 
@@ -1780,28 +1903,38 @@ public:
             output[ix] = sqrt(pow(fft_output[ix].r, 2) + pow(fft_output[ix].i, 2));
         }
 
-        ei_dsp_free(cfg, kiss_fftr_mem_length);
-        ei_dsp_free(fft_output, n_fft_out_features * sizeof(kiss_fft_cpx));
+        release_kiss_fftr_plan(cfg, kiss_fftr_mem_length);
 
         return EIDSP_OK;
     }
 
+    static int software_rfft(float *fft_input, float *output, size_t n_fft, size_t n_fft_out_features) {
+        kiss_fft_cpx *fft_output = (kiss_fft_cpx*)ei_dsp_malloc(n_fft_out_features * sizeof(kiss_fft_cpx));
+        if (!fft_output) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        int ret = software_rfft(fft_input, output, n_fft, n_fft_out_features, fft_output);
+
+        ei_dsp_free(fft_output, n_fft_out_features * sizeof(kiss_fft_cpx));
+
+        return ret;
+    }
+
     static int software_rfft(float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
     {
-        // create fftr context
+        // get fftr context
         size_t kiss_fftr_mem_length;
 
-        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
+        kiss_fftr_cfg cfg = get_kiss_fftr_plan(n_fft, &kiss_fftr_mem_length);
         if (!cfg) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
-
         // execute the rfft operation
         kiss_fftr(cfg, fft_input, (kiss_fft_cpx*)output);
 
-        ei_dsp_free(cfg, kiss_fftr_mem_length);
+        release_kiss_fftr_plan(cfg, kiss_fftr_mem_length);
 
         return EIDSP_OK;
     }
@@ -2296,6 +2429,28 @@ public:
         return status;
 #else
         return arm_rfft_fast_init_f32(rfft_instance, n_fft);
+#endif
+    }
+
+    /**
+     * Initialize a CMSIS-DSP real FFT instance, from the plan cache if enabled
+     */
+    static int get_cmsis_rfft_plan(arm_rfft_fast_instance_f32 *rfft_instance, const size_t n_fft)
+    {
+#if EIDSP_FFT_PLAN_CACHE_SIZE > 0
+        fft_plan_t *plan = get_fft_plan_cache_entry(n_fft);
+        if (!plan->cmsis_initialized) {
+            int status = cmsis_rfft_init_f32(&plan->cmsis_instance, n_fft);
+            if (status != ARM_MATH_SUCCESS) {
+                return status;
+            }
+            plan->cmsis_initialized = true;
+        }
+        // the instance only holds lengths and pointers to the (constant) tables
+        *rfft_instance = plan->cmsis_instance;
+        return ARM_MATH_SUCCESS;
+#else
+        return cmsis_rfft_init_f32(rfft_instance, n_fft);
 #endif
     }
 #endif // #if EIDSP_USE_CMSIS_DSP
@@ -2307,6 +2462,7 @@ public:
      * @param out_buffer Out buffer, size should be fft_points
      * @param out_buffer_size Buffer size
      * @param fft_points (int): The length of FFT. If fft_length is greater than frame_len, the frames will be zero-padded.
+     * @param scratch Optional, rfft_scratch_size(fft_points) floats of scratch space (allocated if NULL)
      * @returns EIDSP_OK if OK
      */
     static int power_spectrum(
@@ -2314,13 +2470,14 @@ public:
         size_t frame_size,
         float *out_buffer,
         size_t out_buffer_size,
-        uint16_t fft_points)
+        uint16_t fft_points,
+        float *scratch = NULL)
     {
         if (out_buffer_size != static_cast<size_t>(fft_points / 2 + 1)) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        int r = numpy::rfft(frame, frame_size, out_buffer, out_buffer_size, fft_points);
+        int r = numpy::rfft(frame, frame_size, out_buffer, out_buffer_size, fft_points, scratch);
         if (r != EIDSP_OK) {
             return r;
         }
@@ -2333,68 +2490,148 @@ public:
         return EIDSP_OK;
     }
 
-    static int welch_max_hold(
-        float *input,
-        size_t input_size,
+    /**
+     * Welch max-hold of every row of a matrix in one batch: the power spectrum of every
+     * (optionally 50% overlapping, zero padded) segment of fft_points samples, and per bin
+     * the max over all segments. The FFT plan and the scratch buffer are set up once for
+     * all rows and segments, and the power is calculated straight from the complex FFT
+     * output, only for start_bin..stop_bin. The input is not modified.
+     * @param input_matrix Input, one row per axis
+     * @param output Out buffer, (stop_bin - start_bin) values per row
+     * @param output_stride Distance between the output of two rows (>= stop_bin - start_bin)
+     * @param start_bin First bin to keep
+     * @param stop_bin Bin after the last bin to keep (<= fft_points / 2 + 1)
+     * @param fft_points FFT length
+     * @param do_overlap Whether segments overlap by fft_points / 2
+     * @returns EIDSP_OK if OK
+     */
+    static int welch_max_hold_rows(
+        const matrix_t *input_matrix,
         float *output,
+        size_t output_stride,
         size_t start_bin,
         size_t stop_bin,
         size_t fft_points,
         bool do_overlap)
     {
-        // save off one point to put back, b/c we're going to calculate in place
-        float saved_point = 0;
-        bool do_saved_point = false;
-        size_t fft_out_size = fft_points / 2 + 1;
-        float *fft_out;
-        ei_unique_ptr_t p_fft_out(nullptr, ei_free);
-        if (input_size < fft_points) {
-            fft_out = (float *)ei_calloc(fft_out_size, sizeof(float));
-            p_fft_out.reset(fft_out);
+        const size_t n_fft_out_features = fft_points / 2 + 1;
+        const size_t num_bins = stop_bin - start_bin;
+        if (start_bin > stop_bin || stop_bin > n_fft_out_features || output_stride < num_bins) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
         }
-        else {
-            // set input as output for in place operation
-            fft_out = input;
-            // save off one point to put back, b/c we're going to calculate in place
-            saved_point = input[fft_points / 2];
-            do_saved_point = true;
-        }
-
-        // init the output to zeros
-        memset(output, 0, sizeof(float) * (stop_bin - start_bin));
-        int input_ix = 0;
-        while (input_ix < (int)input_size) {
-            // Figure out if we need any zero padding
-            size_t n_input_points = input_ix + fft_points <= input_size ? fft_points
-                                                                        : input_size - input_ix;
-            EI_TRY(power_spectrum(
-                input + input_ix,
-                n_input_points,
-                fft_out,
-                fft_points / 2 + 1,
-                fft_points));
-            int j = 0;
-            // keep the max of the last frame and everything before
-            for (size_t i = start_bin; i < stop_bin; i++) {
-                output[j] = std::max(output[j], fft_out[i]);
-                j++;
-            }
-            if (do_overlap) {
-                if (do_saved_point) {
-                    // This step only matters first time through
-                    input[fft_points / 2] = saved_point;
-                    do_saved_point = false;
-                }
-                input_ix += fft_points / 2;
+
+        const size_t input_size = input_matrix->cols;
+        const size_t segment_step = do_overlap ? fft_points / 2 : fft_points;
+        if (segment_step == 0) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        // the zero padded segment + the complex output
+        EI_DSP_MATRIX(scratch, 1, rfft_scratch_size(fft_points));
+        if (!scratch.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        float *fft_input = scratch.buffer;
+        float *fft_output = scratch.buffer + fft_points;
+
+#if EIDSP_USE_CMSIS_DSP
+        // hardware acceleration only works for powers of 2 (32..4096), output is packed
+        // as [ re(0), re(fft_points / 2), re(1), im(1), re(2), im(2), ... ]
+        const bool use_cmsis = fft_points == 32 || fft_points == 64 || fft_points == 128 ||
+            fft_points == 256 || fft_points == 512 || fft_points == 1024 ||
+            fft_points == 2048 || fft_points == 4096;
+        arm_rfft_fast_instance_f32 rfft_instance;
+        if (use_cmsis) {
+            int status = get_cmsis_rfft_plan(&rfft_instance, fft_points);
+            if (status != ARM_MATH_SUCCESS) {
+                return status;
             }
-            else {
-                input_ix += fft_points;
+        }
+#else
+        const bool use_cmsis = false;
+#endif
+
+        kiss_fftr_cfg kiss_cfg = NULL;
+        size_t kiss_cfg_mem_length = 0;
+        if (!use_cmsis) {
+            kiss_cfg = get_kiss_fftr_plan(fft_points, &kiss_cfg_mem_length);
+            if (!kiss_cfg) {
+                EIDSP_ERR(EIDSP_OUT_OF_MEM);
             }
         }
 
+        for (size_t row = 0; row < input_matrix->rows; row++) {
+            const float *input = input_matrix->buffer + (row * input_size);
+            float *row_output = output + (row * output_stride);
+
+            // init the output to zeros
+            memset(row_output, 0, sizeof(float) * num_bins);
+
+            for (size_t input_ix = 0; input_ix < input_size; input_ix += segment_step) {
+                // Figure out if we need any zero padding
+                size_t n_input_points = input_ix + fft_points <= input_size ? fft_points
+                                                                            : input_size - input_ix;
+                memcpy(fft_input, input + input_ix, n_input_points * sizeof(float));
+                memset(fft_input + n_input_points, 0, (fft_points - n_input_points) * sizeof(float));
+
+#if EIDSP_USE_CMSIS_DSP
+                if (use_cmsis) {
+                    arm_rfft_fast_f32(&rfft_instance, fft_input, fft_output, 0);
+                }
+                else
+#endif
+                {
+                    kiss_fftr(kiss_cfg, fft_input, (kiss_fft_cpx *)fft_output);
+                }
+
+                // keep the max of the last frame and everything before
+                for (size_t i = start_bin; i < stop_bin; i++) {
+                    float re = fft_output[i * 2];
+                    float im = fft_output[i * 2 + 1];
+                    if (use_cmsis) {
+                        if (i == 0) {
+                            im = 0.0f;
+                        }
+                        else if (i == n_fft_out_features - 1) {
+                            re = fft_output[1];
+                            im = 0.0f;
+                        }
+                    }
+                    float power = (1.0 / static_cast<float>(fft_points)) * (re * re + im * im);
+                    row_output[i - start_bin] = std::max(row_output[i - start_bin], power);
+                }
+            }
+        }
+
+        release_kiss_fftr_plan(kiss_cfg, kiss_cfg_mem_length);
+
         return EIDSP_OK;
     }
 
+    /**
+     * Welch max-hold of a single signal, see welch_max_hold_rows
+     */
+    static int welch_max_hold(
+        float *input,
+        size_t input_size,
+        float *output,
+        size_t start_bin,
+        size_t stop_bin,
+        size_t fft_points,
+        bool do_overlap)
+    {
+        matrix_t input_matrix(1, input_size, input);
+
+        return welch_max_hold_rows(
+            &input_matrix,
+            output,
+            stop_bin - start_bin,
+            start_bin,
+            stop_bin,
+            fft_points,
+            do_overlap);
+    }
+
     static float variance(float *input, size_t size)
     {
         // Use CMSIS either way.  Will fall back to straight C when needed
@@ -480,6 +480,13 @@ typedef struct ei_signal_t {
 #endif // EIDSP_SIGNAL_C_FN_POINTER == 1
 
     size_t total_length;
+
+    /**
+     * Optional pointer to the complete signal in contiguous memory (`total_length` values).
+     * When set, DSP blocks read straight from this buffer instead of copying the signal
+     * through `get_data`. Leave at nullptr if the signal is not in memory.
+     */
+    const float *buffer = nullptr;
 } signal_t;
 
 #ifdef __cplusplus
@@ -104,8 +104,41 @@ public:
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        // find peaks in FFT
-        EI_DSP_MATRIX(peaks_matrix, axes, fft_peaks * 2);
+        return spectral_analysis_fft_features(
+            out_features,
+            input_matrix,
+            &rms_matrix,
+            sampling_freq,
+            fft_length,
+            fft_peaks,
+            fft_peaks_threshold,
+            edges_matrix_in);
+    }
+
+    /**
+     * Calculate the FFT peaks and spectral power per axis, and write them with the RMS
+     * to the output. The input should already be mean subtracted and filtered.
+     * @param out_features Output matrix, one row per axis
+     * @param input_matrix Signal, with one row per axis
+     * @param rms_matrix RMS of every axis (axes x 1)
+     * @param sampling_freq Sampling frequency of the signal
+     * @param fft_length Length of the FFT signal
+     * @param fft_peaks Number of FFT peaks to find
+     * @param fft_peaks_threshold Minimum threshold
+     * @param edges_matrix Spectral power edges
+     * @returns 0 if OK
+     */
+    static int spectral_analysis_fft_features(
+        matrix_t *out_features,
+        matrix_t *input_matrix,
+        matrix_t *rms_matrix,
+        float sampling_freq,
+        uint16_t fft_length,
+        uint8_t fft_peaks,
+        float fft_peaks_threshold,
+        matrix_t *edges_matrix_in
+    ) {
+        int ret;
 
         for (size_t row = 0; row < input_matrix->rows; row++) {
             // per axis code
@@ -155,7 +188,7 @@ public:
 
             size_t fx = 0;
 
-            features_row[fx++] = rms_matrix.buffer[row];
+            features_row[fx++] = rms_matrix->buffer[row];
             for (size_t peak_row = 0; peak_row < peaks_matrix.rows; peak_row++) {
                 features_row[fx++] = peaks_matrix.buffer[peak_row * peaks_matrix.cols + 0];
                 features_row[fx++] = peaks_matrix.buffer[peak_row * peaks_matrix.cols + 1];
@@ -187,38 +220,24 @@ public:
         return count;
     }
 
-    static int extract_spectral_analysis_features_v1(
-        matrix_t *input_matrix,
-        matrix_t *output_matrix,
-        ei_dsp_config_spectral_analysis_t *config_ptr,
-        const float sampling_freq)
+    /**
+     * Parse the spectral power edges from the config ("0.1, 0.5, 1.0, 2.0, 5.0")
+     * @param edges_str Comma separated list of edges
+     * @param edges_matrix Out matrix (N x 1), rows is set to the number of edges
+     * @returns 0 if OK
+     */
+    static int parse_spectral_power_edges(const char *edges_str, matrix_t *edges_matrix)
     {
-        // scale the signal
-        int ret = numpy::scale(input_matrix, config_ptr->scale_axes);
-        if (ret != EIDSP_OK) {
-            ei_printf("ERR: Failed to scale signal (%d)\n", ret);
-            EIDSP_ERR(ret);
-        }
-
-        // transpose the matrix so we have one row per axis (nifty!)
-        ret = numpy::transpose(input_matrix);
-        if (ret != EIDSP_OK) {
-            ei_printf("ERR: Failed to transpose matrix (%d)\n", ret);
-            EIDSP_ERR(ret);
-        }
-
-        // the spectral edges that we want to calculate
-        matrix_t edges_matrix_in(64, 1);
         size_t edge_matrix_ix = 0;
 
         char spectral_str[128] = { 0 };
-        if (strlen(config_ptr->spectral_power_edges) > sizeof(spectral_str) - 1) {
+        if (strlen(edges_str) > sizeof(spectral_str) - 1) {
             EIDSP_ERR(EIDSP_PARAMETER_INVALID);
         }
         memcpy(
             spectral_str,
-            config_ptr->spectral_power_edges,
-            strlen(config_ptr->spectral_power_edges));
+            edges_str,
+            strlen(edges_str));
 
         // convert spectral_power_edges (string) into float array
         char *spectral_ptr = spectral_str;
@@ -227,7 +246,7 @@ public:
                 spectral_ptr++;
             }
 
-            edges_matrix_in.buffer[edge_matrix_ix++] = atof(spectral_ptr);
+            edges_matrix->buffer[edge_matrix_ix++] = atof(spectral_ptr);
 
             // find next (spectral) delimiter (or '\0' character)
             while ((*spectral_ptr != ',')) {
@@ -243,7 +262,37 @@ public:
                 spectral_ptr++;
             }
         }
-        edges_matrix_in.rows = edge_matrix_ix;
+        edges_matrix->rows = edge_matrix_ix;
+
+        return EIDSP_OK;
+    }
+
+    static int extract_spectral_analysis_features_v1(
+        matrix_t *input_matrix,
+        matrix_t *output_matrix,
+        ei_dsp_config_spectral_analysis_t *config_ptr,
+        const float sampling_freq,
+        bool input_is_transposed = false)
+    {
+        // scale the signal
+        int ret = numpy::scale(input_matrix, config_ptr->scale_axes);
+        if (ret != EIDSP_OK) {
+            ei_printf("ERR: Failed to scale signal (%d)\n", ret);
+            EIDSP_ERR(ret);
+        }
+
+        // transpose the matrix so we have one row per axis (nifty!), unless the caller already did
+        if (!input_is_transposed) {
+            ret = numpy::transpose(input_matrix);
+            if (ret != EIDSP_OK) {
+                ei_printf("ERR: Failed to transpose matrix (%d)\n", ret);
+                EIDSP_ERR(ret);
+            }
+        }
+
+        // the spectral edges that we want to calculate
+        matrix_t edges_matrix_in(64, 1);
+        EI_TRY(parse_spectral_power_edges(config_ptr->spectral_power_edges, &edges_matrix_in));
 
         // calculate how much room we need for the output matrix
         size_t output_matrix_cols = spectral::feature::calculate_spectral_buffer_size(
@@ -293,6 +342,165 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Check a config against the static_config_t it's specialized on (see
+     * ei_dsp_config_*_static_t in model-parameters/dsp_config_static.h), most of the static config
+     * is written by hand so can go out of date when the model is exported again.
+     * The number of spectral power edges is checked when the edges are parsed.
+     * @returns EIDSP_OK if they match, EIDSP_PARAMETER_INVALID otherwise
+     */
+    template<typename static_config_t>
+    static int check_static_config(const ei_dsp_config_spectral_analysis_t *config)
+    {
+        static_assert(static_config_t::axes > 0 && static_config_t::frames > 0,
+            "static config needs the number of axes and frames");
+        static_assert(static_config_t::filter_order >= 0 && static_config_t::filter_order % 2 == 0,
+            "filter_order needs to be even, or 0 if there's no filter");
+        static_assert(static_config_t::fft_length > 0, "fft_length needs to be set");
+        static_assert(static_config_t::spectral_peaks_count >= 0 && static_config_t::spectral_edges_count >= 0,
+            "spectral_peaks_count and spectral_edges_count can't be negative");
+
+        const bool is_high_pass = strcmp(config->filter_type, "high") == 0;
+        const bool do_filter = is_high_pass || strcmp(config->filter_type, "low") == 0;
+        const int filter_order = do_filter ? config->filter_order : 0;
+
+        if (config->implementation_version != static_config_t::implementation_version ||
+                config->axes != static_config_t::axes ||
+                (strcmp(config->analysis_type, "FFT") == 0) != static_config_t::analysis_fft ||
+                filter_order != static_config_t::filter_order ||
+                (do_filter && is_high_pass != static_config_t::filter_high_pass) ||
+                config->fft_length != static_config_t::fft_length ||
+                config->spectral_peaks_count != static_config_t::spectral_peaks_count) {
+            ei_printf("ERR: DSP config does not match its static config (EI_CLASSIFIER_DSP_SPECIALIZED)\n");
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * extract_spectral_analysis_features_v1 with the shape of the config fixed at compile time
+     * (see ei_dsp_config_*_static_t in model-parameters/dsp_config_static.h). The filter type and order, FFT length,
+     * number of peaks / edges and the window length are template parameters, so all buffers
+     * are on the stack, the filter sections are unrolled and there's no string compare.
+     * Gives the same features as extract_spectral_analysis_features_v1.
+     * @param input_matrix Scaled signal, one row per axis (axes x frames), modified in place
+     * @param output_matrix Output matrix, axes * features per axis values
+     * @param config_ptr Config, for the values that are not part of static_config_t
+     * @param sampling_freq Sampling frequency of the signal
+     * @returns EIDSP_OK if OK
+     */
+    template<typename static_config_t>
+    static int extract_spectral_analysis_features_v1_static(
+        matrix_t *input_matrix,
+        matrix_t *output_matrix,
+        ei_dsp_config_spectral_analysis_t *config_ptr,
+        const float sampling_freq)
+    {
+        constexpr size_t axes = static_config_t::axes;
+        constexpr size_t frames = static_config_t::frames;
+        constexpr int filter_order = static_config_t::filter_order;
+        constexpr uint16_t fft_length = static_config_t::fft_length;
+        constexpr size_t fft_out_size = fft_length / 2 + 1;
+        constexpr size_t peaks_count = static_config_t::spectral_peaks_count;
+        constexpr size_t edges_count = static_config_t::spectral_edges_count;
+        constexpr size_t features_per_axis = 1 + (peaks_count * 2) + (edges_count > 0 ? edges_count - 1 : 0);
+
+        if (input_matrix->rows != axes || input_matrix->cols != frames) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+        if (output_matrix->rows * output_matrix->cols != axes * features_per_axis) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        // the edges are only known as a string, check they match the compile time count
+        float edges_in_buffer[64];
+        matrix_t edges_matrix_in(64, 1, edges_in_buffer);
+        EI_TRY(parse_spectral_power_edges(config_ptr->spectral_power_edges, &edges_matrix_in));
+        if (edges_matrix_in.rows != edges_count) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        float mean_buffer[axes];
+        matrix_t mean_matrix(axes, 1, mean_buffer);
+        EI_TRY(numpy::mean(input_matrix, &mean_matrix));
+        EI_TRY(numpy::subtract(input_matrix, &mean_matrix));
+
+        if (filter_order > 0) {
+            filters::butterworth_filter_t filter;
+            EI_TRY(filters::get_butterworth_filter(&filter, filter_order, sampling_freq,
+                config_ptr->filter_cutoff, static_config_t::filter_high_pass));
+
+#if EIDSP_BUTTERWORTH_VECTORIZED == 1
+            filters::butterworth_filter_apply_rows(&filter, input_matrix->buffer, axes, frames);
+#else
+            // (only instantiated with a valid order, filter_order is 0 if there's no filter)
+            constexpr int valid_filter_order = filter_order > 0 ? filter_order : 2;
+            for (size_t row = 0; row < axes; row++) {
+                float *row_ptr = input_matrix->buffer + (row * frames);
+                filters::butterworth_filter<valid_filter_order, static_config_t::filter_high_pass>(
+                    filter.A, filter.d1, filter.d2, row_ptr, row_ptr, frames);
+            }
+#endif
+        }
+
+        float rms_buffer[axes];
+        matrix_t rms_matrix(axes, 1, rms_buffer);
+        EI_TRY(numpy::rms(input_matrix, &rms_matrix));
+
+        float fft_scratch[fft_length + (fft_out_size * 2)];
+        float fft_buffer[fft_out_size];
+        float period_fft_buffer[fft_out_size];
+        float period_freq_buffer[fft_out_size];
+        float peaks_buffer[peaks_count > 0 ? peaks_count * 2 : 1];
+        float edges_out_buffer[edges_count > 1 ? edges_count - 1 : 1];
+
+        for (size_t row = 0; row < axes; row++) {
+            matrix_t axis_matrix(1, frames, input_matrix->buffer + (row * frames));
+
+            matrix_t fft_matrix(1, fft_out_size, fft_buffer);
+            EI_TRY(numpy::rfft(axis_matrix.buffer, frames, fft_buffer, fft_out_size, fft_length, fft_scratch));
+
+            // multiply by 2/N
+            numpy::scale(&fft_matrix, (2.0f / static_cast<float>(fft_length)));
+
+            matrix_t peaks_matrix(peaks_count, 2, peaks_buffer);
+            EI_TRY(spectral::processing::find_fft_peaks(&fft_matrix, &peaks_matrix,
+                sampling_freq, config_ptr->spectral_peaks_threshold, fft_length));
+
+            matrix_t period_fft_matrix(1, fft_out_size, period_fft_buffer);
+            matrix_t period_freq_matrix(1, fft_out_size, period_freq_buffer);
+            EI_TRY(spectral::processing::periodogram(&axis_matrix,
+                &period_fft_matrix, &period_freq_matrix, sampling_freq, fft_length));
+
+            matrix_t edges_matrix_out(edges_count - 1, 1, edges_out_buffer);
+            EI_TRY(spectral::processing::spectral_power_edges(
+                &period_fft_matrix,
+                &period_freq_matrix,
+                &edges_matrix_in,
+                &edges_matrix_out,
+                sampling_freq));
+
+            float *features_row = output_matrix->buffer + (row * features_per_axis);
+
+            size_t fx = 0;
+
+            features_row[fx++] = rms_buffer[row];
+            for (size_t peak_row = 0; peak_row < peaks_count; peak_row++) {
+                features_row[fx++] = peaks_buffer[peak_row * 2 + 0];
+                features_row[fx++] = peaks_buffer[peak_row * 2 + 1];
+            }
+            for (size_t edge_row = 0; edge_row + 1 < edges_count; edge_row++) {
+                features_row[fx++] = edges_out_buffer[edge_row] / 10.0f;
+            }
+        }
+
+        output_matrix->cols = axes * features_per_axis;
+        output_matrix->rows = 1;
+
+        return EIDSP_OK;
+    }
+
     static void get_start_stop_bin(
         float sampling_freq,
         size_t fft_length,
@@ -320,10 +528,13 @@ public:
         matrix_t *input_matrix,
         matrix_t *output_matrix,
         ei_dsp_config_spectral_analysis_t *config,
-        const float sampling_freq)
+        const float sampling_freq,
+        bool input_is_transposed = false)
     {
-        // transpose the matrix so we have one row per axis
-        numpy::transpose_in_place(input_matrix);
+        // transpose the matrix so we have one row per axis (unless the caller already did)
+        if (!input_is_transposed) {
+            numpy::transpose_in_place(input_matrix);
+        }
 
         // func tests for scale of 1 and does a no op in that case
         EI_TRY(numpy::scale(input_matrix, config->scale_axes));
@@ -356,8 +567,6 @@ public:
             is_high_pass = true;
         }
 
-        EI_TRY(processing::subtract_mean(input_matrix));
-
         // Figure bins we remove based on filter cutoff
         size_t start_bin, stop_bin;
         if (do_filter) {
@@ -380,11 +589,11 @@ public:
             float *data_window = input_matrix->get_row_ptr(row);
             size_t data_size = input_matrix->cols;
 
-            matrix_t rms_in_matrix(1, data_size, data_window);
-            matrix_t rms_out_matrix(1, 1, feature_out);
-            EI_TRY(numpy::rms(&rms_in_matrix, &rms_out_matrix));
+            // subtract the mean, and get the sums for RMS, skew and kurtosis, in one pass
+            float power_sums[3];
+            processing::subtract_mean_and_sum_powers(data_window, data_size, power_sums);
 
-            feature_out++;
+            *feature_out++ = sqrt(power_sums[0] / static_cast<float>(data_size));
 
             // Standard Deviation
             float stddev = *(feature_out-1); //= sqrt(numpy::variance(data_window, data_size));
@@ -400,37 +609,420 @@ public:
             // Kurtosis becomes: mean(X^4) / stddev^4
             // Note, this is the Fisher definition of Kurtosis, so subtract 3
             // (see https://docs.scipy.org/doc/scipy/reference/generated/scipy.stats.kurtosis.html)
-            float s_sum = 0;
-            float k_sum = 0;
-            float temp;
-            for (size_t i = 0; i < data_size; i++) {
-                temp = data_window[i] * data_window[i] * data_window[i];
-                s_sum += temp;
-                k_sum += temp * data_window[i];
-            }
+            float s_sum = power_sums[1];
+            float k_sum = power_sums[2];
             // Skewness out
-            temp = stddev * stddev * stddev;
+            float temp = stddev * stddev * stddev;
             *feature_out++ = (s_sum / data_size) / temp;
             // Kurtosis out
             *feature_out++ = ((k_sum / data_size) / (temp * stddev)) - 3;
 
-            EI_TRY(numpy::welch_max_hold(
-                data_window,
-                data_size,
-                feature_out,
-                start_bin,
-                stop_bin,
-                config->fft_length,
-                config->do_fft_overlap));
-            if (config->do_log) {
-                numpy::zero_handling(feature_out, num_bins);
-                ei_matrix temp(num_bins, 1, feature_out);
+            // spectral power is filled in below, for all axes at once
+            feature_out += num_bins;
+        }
+
+        // per axis 3 statistics, followed by the spectral power
+        const size_t features_per_axis = 3 + num_bins;
+        EI_TRY(numpy::welch_max_hold_rows(
+            input_matrix,
+            output_matrix->buffer + 3,
+            features_per_axis,
+            start_bin,
+            stop_bin,
+            config->fft_length,
+            config->do_fft_overlap));
+
+        if (config->do_log) {
+            for (size_t row = 0; row < input_matrix->rows; row++) {
+                float *power_out = output_matrix->buffer + (row * features_per_axis) + 3;
+                numpy::zero_handling(power_out, num_bins);
+                ei_matrix temp(num_bins, 1, power_out);
                 numpy::log10(&temp);
             }
+        }
+        return EIDSP_OK;
+    }
+
+    /**
+     * State to calculate spectral analysis (FFT) features over a sliding window that is
+     * fed one slice at a time. The signal is kept in a ring buffer per axis.
+     *
+     * Without a filter the ring buffer holds the scaled signal together with running power
+     * sums, so adding a slice costs O(slice) and only the FFT needs a pass over the full
+     * window. The moments come from the running sums (in double) rather than from a pass
+     * over the window, so features differ in the last bits from
+     * extract_spectral_analysis_features_v1/v2 on the same window (measured on accelerometer
+     * data at 62.5 Hz, 125 frames, slices of 31: v1 at most 3e-7 relative, v2 at most 4e-4
+     * relative on RMS / skewness / kurtosis and 1e-4 on the spectral power).
+     *
+     * With a filter the batch features filter every window from a zero filter state, and the
+     * model is trained on those (start-up transient included). A filter state carried over
+     * between slices gives different features (up to several times the value for skewness
+     * and kurtosis), so here the ring buffer holds the raw signal and every window goes
+     * through extract_spectral_analysis_features_v1/v2: same features as the batch path,
+     * at the cost of filtering the full window once per slice.
+     */
+    typedef struct {
+        const ei_dsp_config_spectral_analysis_t *config;
+        size_t axes;
+        size_t window_frames;
+        size_t frames_seen;         // number of frames in the window (up to window_frames)
+        size_t head;                // next frame to write in the ring buffers
+        float *window;              // ring buffers, axes x window_frames
+        float *shift;               // per axis, sums are taken over (x - shift) for precision
+        double *sums;               // per axis, sum of (x - shift)^1 .. (x - shift)^4
+        bool do_filter;             // window holds the raw signal, features via the batch path
+    } spectral_stream_t;
+
+    static void spectral_stream_free(spectral_stream_t *stream)
+    {
+        if (stream->window) ei_free(stream->window);
+        if (stream->shift) ei_free(stream->shift);
+        if (stream->sums) ei_free(stream->sums);
+        memset(stream, 0, sizeof(spectral_stream_t));
+    }
+
+    /**
+     * Allocate the state for a sliding window of window_frames frames
+     * @param stream Stream (free with spectral_stream_free)
+     * @param config Spectral analysis config, needs to stay alive while the stream is used
+     * @param window_frames Number of frames (samples per axis) in the window
+     * @returns EIDSP_OK if OK
+     */
+    static int spectral_stream_init(
+        spectral_stream_t *stream,
+        const ei_dsp_config_spectral_analysis_t *config,
+        size_t window_frames)
+    {
+        memset(stream, 0, sizeof(spectral_stream_t));
+
+        if (strcmp(config->analysis_type, "FFT") != 0) {
+            EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+        }
+
+        stream->config = config;
+        stream->axes = config->axes;
+        stream->window_frames = window_frames;
+
+        if (strcmp(config->filter_type, "low") == 0 || strcmp(config->filter_type, "high") == 0) {
+            stream->do_filter = true;
+        }
+
+        stream->window = (float*)ei_calloc(stream->axes * window_frames, sizeof(float));
+        if (!stream->do_filter) {
+            stream->shift = (float*)ei_calloc(stream->axes, sizeof(float));
+            stream->sums = (double*)ei_calloc(stream->axes * 4, sizeof(double));
+        }
+
+        if (!stream->window || (!stream->do_filter && (!stream->shift || !stream->sums))) {
+            spectral_stream_free(stream);
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Recalculate the power sums of an axis from its ring buffer. Done once per window
+     * length so rounding errors from the running updates don't pile up. The shift is
+     * moved to the current mean to keep the sums small.
+     */
+    static void spectral_stream_recalculate_sums(spectral_stream_t *stream, size_t axis)
+    {
+        const float *window = stream->window + (axis * stream->window_frames);
+        double *sums = stream->sums + (axis * 4);
+
+        double mean = 0;
+        for (size_t ix = 0; ix < stream->frames_seen; ix++) {
+            mean += window[ix];
+        }
+        mean /= stream->frames_seen;
+        stream->shift[axis] = (float)mean;
+
+        sums[0] = sums[1] = sums[2] = sums[3] = 0;
+        for (size_t ix = 0; ix < stream->frames_seen; ix++) {
+            double x = window[ix] - stream->shift[axis];
+            double x2 = x * x;
+            sums[0] += x;
+            sums[1] += x2;
+            sums[2] += x2 * x;
+            sums[3] += x2 * x2;
+        }
+    }
+
+    /**
+     * Add a slice to the window
+     * @param stream Stream
+     * @param slice Matrix with one row per frame, one column per axis
+     * @returns EIDSP_OK if OK
+     */
+    static int spectral_stream_add_slice(spectral_stream_t *stream, matrix_t *slice)
+    {
+        if (slice->cols != stream->axes) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        const float scale = stream->config->scale_axes;
+
+        for (size_t row = 0; row < slice->rows; row++) {
+            bool window_full = stream->frames_seen == stream->window_frames;
+
+            for (size_t axis = 0; axis < stream->axes; axis++) {
+                float x = slice->buffer[row * slice->cols + axis];
+                float *slot = stream->window + (axis * stream->window_frames) + stream->head;
+
+                // filtered windows are calculated by the batch path, which scales itself
+                if (stream->do_filter) {
+                    *slot = x;
+                    continue;
+                }
+
+                if (scale != 1.0f) {
+                    x *= scale;
+                }
+                double *sums = stream->sums + (axis * 4);
+
+                if (window_full) {
+                    double old = *slot - stream->shift[axis];
+                    double old2 = old * old;
+                    sums[0] -= old;
+                    sums[1] -= old2;
+                    sums[2] -= old2 * old;
+                    sums[3] -= old2 * old2;
+                }
+                else if (stream->frames_seen == 0) {
+                    stream->shift[axis] = x;
+                }
+
+                *slot = x;
+
+                double v = x - stream->shift[axis];
+                double v2 = v * v;
+                sums[0] += v;
+                sums[1] += v2;
+                sums[2] += v2 * v;
+                sums[3] += v2 * v2;
+            }
+
+            if (!window_full) {
+                stream->frames_seen++;
+            }
+
+            stream->head++;
+            if (stream->head == stream->window_frames) {
+                stream->head = 0;
+                for (size_t axis = 0; stream->sums && axis < stream->axes; axis++) {
+                    spectral_stream_recalculate_sums(stream, axis);
+                }
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Copy the window of an axis in chronological order, with an offset subtracted
+     */
+    static void spectral_stream_copy_window(spectral_stream_t *stream, size_t axis, float offset, float *out)
+    {
+        const size_t size = stream->window_frames;
+        const float *window = stream->window + (axis * size);
+        const size_t first = size - stream->head;
+
+        for (size_t ix = 0; ix < first; ix++) {
+            out[ix] = window[stream->head + ix] - offset;
+        }
+        for (size_t ix = first; ix < size; ix++) {
+            out[ix] = window[ix - first] - offset;
+        }
+    }
+
+    /**
+     * Mean and central moments of an axis in the window, from the running power sums
+     * @param moments Out: mean, variance, 3rd and 4th central moment
+     */
+    static void spectral_stream_moments(spectral_stream_t *stream, size_t axis, double moments[4])
+    {
+        const double *sums = stream->sums + (axis * 4);
+        const double n = (double)stream->window_frames;
+
+        double m1 = sums[0] / n;
+        double m1_2 = m1 * m1;
+        moments[0] = stream->shift[axis] + m1;
+        moments[1] = (sums[1] / n) - m1_2;
+        moments[2] = (sums[2] / n) - (3 * m1 * sums[1] / n) + (2 * m1_2 * m1);
+        moments[3] = (sums[3] / n) - (4 * m1 * sums[2] / n) + (6 * m1_2 * sums[1] / n) - (3 * m1_2 * m1_2);
+        if (moments[1] < 0) {
+            moments[1] = 0;
+        }
+    }
+
+    static int spectral_stream_get_features_v1(
+        spectral_stream_t *stream,
+        matrix_t *output_matrix,
+        const float sampling_freq)
+    {
+        const ei_dsp_config_spectral_analysis_t *config = stream->config;
+
+        matrix_t edges_matrix_in(64, 1);
+        EI_TRY(parse_spectral_power_edges(config->spectral_power_edges, &edges_matrix_in));
+
+        size_t output_matrix_cols = calculate_spectral_buffer_size(
+            true,
+            config->spectral_peaks_count,
+            edges_matrix_in.rows);
+        if (output_matrix->cols * output_matrix->rows !=
+            static_cast<uint32_t>(output_matrix_cols * stream->axes)) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        // mean subtracted window, and RMS, per axis
+        EI_DSP_MATRIX(input_matrix, stream->axes, stream->window_frames);
+        EI_DSP_MATRIX(rms_matrix, stream->axes, 1);
+        if (!input_matrix.buffer || !rms_matrix.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        for (size_t axis = 0; axis < stream->axes; axis++) {
+            double moments[4];
+            spectral_stream_moments(stream, axis, moments);
+            rms_matrix.buffer[axis] = (float)sqrt(moments[1]);
+            spectral_stream_copy_window(stream, axis, (float)moments[0], input_matrix.get_row_ptr(axis));
+        }
+
+        output_matrix->cols = output_matrix_cols;
+        output_matrix->rows = stream->axes;
+
+        int ret = spectral_analysis_fft_features(
+            output_matrix,
+            &input_matrix,
+            &rms_matrix,
+            sampling_freq,
+            config->fft_length,
+            config->spectral_peaks_count,
+            config->spectral_peaks_threshold,
+            &edges_matrix_in);
+
+        // flatten again
+        output_matrix->cols = stream->axes * output_matrix_cols;
+        output_matrix->rows = 1;
+
+        if (ret != EIDSP_OK) {
+            ei_printf("ERR: Failed to calculate spectral features (%d)\n", ret);
+            EIDSP_ERR(ret);
+        }
+
+        return EIDSP_OK;
+    }
+
+    static int spectral_stream_get_features_v2(
+        spectral_stream_t *stream,
+        matrix_t *output_matrix)
+    {
+        const ei_dsp_config_spectral_analysis_t *config = stream->config;
+
+        // (only used without a filter)
+        const size_t start_bin = 1;
+        const size_t stop_bin = config->fft_length / 2 + 1;
+        size_t num_bins = stop_bin - start_bin;
+
+        if (output_matrix->rows * output_matrix->cols != stream->axes * (3 + num_bins)) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        // the mean subtracted windows in chronological order (one row per axis), for the FFT
+        EI_DSP_MATRIX(data_window, stream->axes, stream->window_frames);
+        if (!data_window.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        float *feature_out = output_matrix->buffer;
+        for (size_t axis = 0; axis < stream->axes; axis++) {
+            double moments[4];
+            spectral_stream_moments(stream, axis, moments);
+
+            // RMS of the mean subtracted signal is the standard deviation
+            float stddev = (float)sqrt(moments[1]);
+            *feature_out++ = stddev;
+            if (stddev == 0.0f) {
+                stddev = 1e-10f;
+            }
+
+            // Skewness and kurtosis, see extract_spectral_analysis_features_v2
+            float temp = stddev * stddev * stddev;
+            *feature_out++ = (float)moments[2] / temp;
+            *feature_out++ = ((float)moments[3] / (temp * stddev)) - 3;
+
+            spectral_stream_copy_window(stream, axis, (float)moments[0], data_window.get_row_ptr(axis));
+
+            // spectral power is filled in below, for all axes at once
             feature_out += num_bins;
         }
+
+        const size_t features_per_axis = 3 + num_bins;
+        EI_TRY(numpy::welch_max_hold_rows(
+            &data_window,
+            output_matrix->buffer + 3,
+            features_per_axis,
+            start_bin,
+            stop_bin,
+            config->fft_length,
+            config->do_fft_overlap));
+
+        if (config->do_log) {
+            for (size_t axis = 0; axis < stream->axes; axis++) {
+                float *power_out = output_matrix->buffer + (axis * features_per_axis) + 3;
+                numpy::zero_handling(power_out, num_bins);
+                ei_matrix temp(num_bins, 1, power_out);
+                numpy::log10(&temp);
+            }
+        }
+
         return EIDSP_OK;
     }
+
+    /**
+     * Calculate the features over the current window, same layout as
+     * extract_spectral_analysis_features_v1 / v2 (depending on the config)
+     * @param stream Stream
+     * @param output_matrix Output matrix
+     * @param sampling_freq Sampling frequency of the signal
+     * @returns EIDSP_OK if OK, EIDSP_BUFFER_SIZE_MISMATCH if the window is not full yet
+     */
+    static int spectral_stream_get_features(
+        spectral_stream_t *stream,
+        matrix_t *output_matrix,
+        const float sampling_freq)
+    {
+        if (stream->frames_seen < stream->window_frames) {
+            return EIDSP_BUFFER_SIZE_MISMATCH;
+        }
+
+        if (stream->do_filter) {
+            // the raw window in chronological order (one row per axis), through the batch path
+            ei_dsp_config_spectral_analysis_t *config =
+                const_cast<ei_dsp_config_spectral_analysis_t *>(stream->config);
+            EI_DSP_MATRIX(input_matrix, stream->axes, stream->window_frames);
+            if (!input_matrix.buffer) {
+                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            }
+            for (size_t axis = 0; axis < stream->axes; axis++) {
+                spectral_stream_copy_window(stream, axis, 0.0f, input_matrix.get_row_ptr(axis));
+            }
+
+            if (config->implementation_version == 1) {
+                return extract_spectral_analysis_features_v1(
+                    &input_matrix, output_matrix, config, sampling_freq, true);
+            }
+            return extract_spectral_analysis_features_v2(
+                &input_matrix, output_matrix, config, sampling_freq, true);
+        }
+
+        if (stream->config->implementation_version == 1) {
+            return spectral_stream_get_features_v1(stream, output_matrix, sampling_freq);
+        }
+        return spectral_stream_get_features_v2(stream, output_matrix);
+    }
 };
 
 } // namespace spectral
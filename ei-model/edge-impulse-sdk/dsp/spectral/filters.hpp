@@ -20,6 +20,18 @@
 
 #include <math.h>
 #include "../numpy.hpp"
+#include "../config.hpp"
+#include "../ei_utils.h"
+
+#if EIDSP_BUTTERWORTH_VECTORIZED == 1
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#endif // EIDSP_BUTTERWORTH_VECTORIZED == 1
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846264338327950288
@@ -29,115 +41,363 @@ namespace ei {
 namespace spectral {
 namespace filters {
     /**
-     * The Butterworth filter has maximally flat frequency response in the passband.
+     * Calculate the Butterworth filter parameters, the filter is applied as a cascade of
+     * filter_order / 2 second order sections.
      * @param filter_order Even filter order (between 2..8)
      * @param sampling_freq Sample frequency of the signal
      * @param cutoff_freq Cut-off frequency of the signal
-     * @param src Source array
-     * @param dest Destination array
-     * @param size Size of both source and destination arrays
+     * @param is_high_pass Whether to calculate a highpass (or lowpass) filter
+     * @param A Out array with the gain per section (filter_order / 2 elements)
+     * @param d1 Out array with the first feedback coefficient per section
+     * @param d2 Out array with the second feedback coefficient per section
      */
-    static void butterworth_lowpass(
+    static void butterworth_coefficients(
         int filter_order,
         float sampling_freq,
         float cutoff_freq,
-        const float *src,
-        float *dest,
-        size_t size)
+        bool is_high_pass,
+        float *A,
+        float *d1,
+        float *d2)
     {
         int n_steps = filter_order / 2;
         float a = tan(M_PI * cutoff_freq / sampling_freq);
         float a2 = pow(a, 2);
-        float *A = (float*)ei_calloc(n_steps, sizeof(float));
-        float *d1 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *d2 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w0 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w1 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w2 = (float*)ei_calloc(n_steps, sizeof(float));
-
-        // Calculate the filter parameters
-        for(int ix = 0; ix < n_steps; ix++) {
+
+        for (int ix = 0; ix < n_steps; ix++) {
             float r = sin(M_PI * ((2.0 * ix) + 1.0) / (2.0 * filter_order));
-            sampling_freq = a2 + (2.0 * a * r) + 1.0;
-            A[ix] = a2 / sampling_freq;
-            d1[ix] = 2.0 * (1 - a2) / sampling_freq;
-            d2[ix] = -(a2 - (2.0 * a * r) + 1.0) / sampling_freq;
+            float s = a2 + (2.0 * a * r) + 1.0;
+            A[ix] = is_high_pass ? 1.0f / s : a2 / s;
+            d1[ix] = 2.0 * (1 - a2) / s;
+            d2[ix] = -(a2 - (2.0 * a * r) + 1.0) / s;
+        }
+    }
+
+    /**
+     * Butterworth filter (cascade of second order sections) that keeps its coefficients and
+     * state between calls. Filtering a signal in several parts gives the same result as
+     * filtering it in one go, and re-initializing with the same parameters does not
+     * recalculate the coefficients.
+     */
+    typedef struct {
+        int filter_order;
+        float sampling_freq;
+        float cutoff_freq;
+        bool is_high_pass;
+        int n_steps;
+        float A[EIDSP_BUTTERWORTH_MAX_ORDER / 2];
+        float d1[EIDSP_BUTTERWORTH_MAX_ORDER / 2];
+        float d2[EIDSP_BUTTERWORTH_MAX_ORDER / 2];
+        float w1[EIDSP_BUTTERWORTH_MAX_ORDER / 2];
+        float w2[EIDSP_BUTTERWORTH_MAX_ORDER / 2];
+    } butterworth_filter_t;
+
+    /**
+     * Clear the state of a filter, so the next sample starts a new signal
+     * @param filter Filter
+     */
+    static void butterworth_filter_reset(butterworth_filter_t *filter)
+    {
+        for (int ix = 0; ix < filter->n_steps; ix++) {
+            filter->w1[ix] = 0.0f;
+            filter->w2[ix] = 0.0f;
         }
+    }
+
+    /**
+     * Set up a filter, and clear its state. Coefficients are only calculated if the
+     * filter was not set up with these parameters before.
+     * @param filter Filter (zero initialize before the first call)
+     * @param filter_order Even filter order (between 2..EIDSP_BUTTERWORTH_MAX_ORDER)
+     * @param sampling_freq Sample frequency of the signal
+     * @param cutoff_freq Cut-off frequency of the signal
+     * @param is_high_pass Whether to calculate a highpass (or lowpass) filter
+     * @returns EIDSP_OK if OK
+     */
+    static int butterworth_filter_init(
+        butterworth_filter_t *filter,
+        int filter_order,
+        float sampling_freq,
+        float cutoff_freq,
+        bool is_high_pass)
+    {
+        if (filter_order < 0 || filter_order / 2 > EIDSP_BUTTERWORTH_MAX_ORDER / 2) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        bool configured = filter->n_steps == filter_order / 2 &&
+            filter->filter_order == filter_order &&
+            filter->sampling_freq == sampling_freq &&
+            filter->cutoff_freq == cutoff_freq &&
+            filter->is_high_pass == is_high_pass;
+
+        if (!configured) {
+            filter->filter_order = filter_order;
+            filter->sampling_freq = sampling_freq;
+            filter->cutoff_freq = cutoff_freq;
+            filter->is_high_pass = is_high_pass;
+            filter->n_steps = filter_order / 2;
+            butterworth_coefficients(filter_order, sampling_freq, cutoff_freq, is_high_pass,
+                filter->A, filter->d1, filter->d2);
+        }
+
+        butterworth_filter_reset(filter);
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Filter a signal, continuing from the state left by the previous call
+     * @param filter Filter (see butterworth_filter_init)
+     * @param src Source array
+     * @param dest Destination array (can be the same as src)
+     * @param size Size of both source and destination arrays
+     */
+    static void butterworth_filter_apply(
+        butterworth_filter_t *filter,
+        const float *src,
+        float *dest,
+        size_t size)
+    {
+        const int n_steps = filter->n_steps;
+        const float *A = filter->A;
+        const float *d1 = filter->d1;
+        const float *d2 = filter->d2;
+        float *w1 = filter->w1;
+        float *w2 = filter->w2;
 
-        // Apply the filter
         for (size_t sx = 0; sx < size; sx++) {
             dest[sx] = src[sx];
 
             for (int i = 0; i < n_steps; i++) {
-                w0[i] = d1[i] * w1[i] + d2[i] * w2[i] + dest[sx];
-                dest[sx] = A[i] * (w0[i] + (2.0 * w1[i]) + w2[i]);
+                float w0 = d1[i] * w1[i] + d2[i] * w2[i] + dest[sx];
+                if (filter->is_high_pass) {
+                    dest[sx] = A[i] * (w0 - (2.0 * w1[i]) + w2[i]);
+                }
+                else {
+                    dest[sx] = A[i] * (w0 + (2.0 * w1[i]) + w2[i]);
+                }
                 w2[i] = w1[i];
-                w1[i] = w0[i];
+                w1[i] = w0;
+            }
+        }
+    }
+
+#if EIDSP_BUTTERWORTH_VECTORIZED == 1
+    // a vector of butterworth_filter_apply_rows lanes (one row per lane), in a SIMD register if available
+#if defined(__AVX__)
+    struct butterworth_lanes_t {
+        static constexpr size_t lanes = 8;
+        typedef __m256 vec_t;
+        static vec_t load(const float *p) { return _mm256_loadu_ps(p); }
+        static void store(float *p, vec_t v) { _mm256_storeu_ps(p, v); }
+        static vec_t set1(float v) { return _mm256_set1_ps(v); }
+        static vec_t add(vec_t a, vec_t b) { return _mm256_add_ps(a, b); }
+        static vec_t sub(vec_t a, vec_t b) { return _mm256_sub_ps(a, b); }
+        static vec_t mul(vec_t a, vec_t b) { return _mm256_mul_ps(a, b); }
+    };
+#elif defined(__SSE2__) || defined(_M_X64)
+    struct butterworth_lanes_t {
+        static constexpr size_t lanes = 4;
+        typedef __m128 vec_t;
+        static vec_t load(const float *p) { return _mm_loadu_ps(p); }
+        static void store(float *p, vec_t v) { _mm_storeu_ps(p, v); }
+        static vec_t set1(float v) { return _mm_set1_ps(v); }
+        static vec_t add(vec_t a, vec_t b) { return _mm_add_ps(a, b); }
+        static vec_t sub(vec_t a, vec_t b) { return _mm_sub_ps(a, b); }
+        static vec_t mul(vec_t a, vec_t b) { return _mm_mul_ps(a, b); }
+    };
+#elif defined(__ARM_NEON)
+    struct butterworth_lanes_t {
+        static constexpr size_t lanes = 4;
+        typedef float32x4_t vec_t;
+        static vec_t load(const float *p) { return vld1q_f32(p); }
+        static void store(float *p, vec_t v) { vst1q_f32(p, v); }
+        static vec_t set1(float v) { return vdupq_n_f32(v); }
+        static vec_t add(vec_t a, vec_t b) { return vaddq_f32(a, b); }
+        static vec_t sub(vec_t a, vec_t b) { return vsubq_f32(a, b); }
+        static vec_t mul(vec_t a, vec_t b) { return vmulq_f32(a, b); }
+    };
+#else
+    struct butterworth_lanes_t {
+        static constexpr size_t lanes = 4;
+        typedef struct { float v[4]; } vec_t;
+        static vec_t load(const float *p) { vec_t r; for (size_t i = 0; i < 4; i++) r.v[i] = p[i]; return r; }
+        static void store(float *p, vec_t a) { for (size_t i = 0; i < 4; i++) p[i] = a.v[i]; }
+        static vec_t set1(float v) { vec_t r; for (size_t i = 0; i < 4; i++) r.v[i] = v; return r; }
+        static vec_t add(vec_t a, vec_t b) { for (size_t i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+        static vec_t sub(vec_t a, vec_t b) { for (size_t i = 0; i < 4; i++) a.v[i] -= b.v[i]; return a; }
+        static vec_t mul(vec_t a, vec_t b) { for (size_t i = 0; i < 4; i++) a.v[i] *= b.v[i]; return a; }
+    };
+#endif
+
+    /**
+     * Filter up to butterworth_lanes_t::lanes rows at once, one row per lane. Same
+     * recurrence as butterworth_filter_apply, but in float only (butterworth_filter_apply
+     * calculates the output of every section in double), so results differ in the last bits.
+     */
+    template<bool IS_HIGH_PASS>
+    static void butterworth_filter_apply_lanes(
+        const butterworth_filter_t *filter,
+        float *buffer,
+        size_t rows,
+        size_t cols)
+    {
+        typedef butterworth_lanes_t V;
+        const int n_steps = filter->n_steps;
+
+        V::vec_t A[EIDSP_BUTTERWORTH_MAX_ORDER / 2];
+        V::vec_t d1[EIDSP_BUTTERWORTH_MAX_ORDER / 2];
+        V::vec_t d2[EIDSP_BUTTERWORTH_MAX_ORDER / 2];
+        V::vec_t w1[EIDSP_BUTTERWORTH_MAX_ORDER / 2];
+        V::vec_t w2[EIDSP_BUTTERWORTH_MAX_ORDER / 2];
+        for (int i = 0; i < n_steps; i++) {
+            A[i] = V::set1(filter->A[i]);
+            d1[i] = V::set1(filter->d1[i]);
+            d2[i] = V::set1(filter->d2[i]);
+            w1[i] = V::set1(0.0f);
+            w2[i] = V::set1(0.0f);
+        }
+        const V::vec_t two = V::set1(2.0f);
+
+        float lanes[V::lanes] = { 0 };
+
+        for (size_t sx = 0; sx < cols; sx++) {
+            for (size_t lane = 0; lane < rows; lane++) {
+                lanes[lane] = buffer[lane * cols + sx];
+            }
+            V::vec_t x = V::load(lanes);
+
+            for (int i = 0; i < n_steps; i++) {
+                V::vec_t w0 = V::add(V::add(V::mul(d1[i], w1[i]), V::mul(d2[i], w2[i])), x);
+                if (IS_HIGH_PASS) {
+                    x = V::mul(A[i], V::add(V::sub(w0, V::mul(two, w1[i])), w2[i]));
+                }
+                else {
+                    x = V::mul(A[i], V::add(V::add(w0, V::mul(two, w1[i])), w2[i]));
+                }
+                w2[i] = w1[i];
+                w1[i] = w0;
+            }
+
+            V::store(lanes, x);
+            for (size_t lane = 0; lane < rows; lane++) {
+                buffer[lane * cols + sx] = lanes[lane];
             }
         }
+    }
+#endif // EIDSP_BUTTERWORTH_VECTORIZED == 1
+
+    /**
+     * Filter every row of a matrix (e.g. one row per axis) with the same filter. Every row
+     * starts from a cleared state, the state of the filter itself is not used or changed.
+     * With EIDSP_BUTTERWORTH_VECTORIZED the rows are filtered together in SIMD lanes; a
+     * single row left over (e.g. one axis) goes through butterworth_filter_apply instead,
+     * which doesn't have to move the row in and out of the lanes.
+     * @param filter Filter (see butterworth_filter_init)
+     * @param buffer Rows x cols values, filtered in place
+     * @param rows Number of rows
+     * @param cols Number of values per row
+     */
+    static void butterworth_filter_apply_rows(
+        const butterworth_filter_t *filter,
+        float *buffer,
+        size_t rows,
+        size_t cols)
+    {
+#if EIDSP_BUTTERWORTH_VECTORIZED == 1
+        const size_t lanes = butterworth_lanes_t::lanes;
 
-        ei_free(A);
-        ei_free(d1);
-        ei_free(d2);
-        ei_free(w0);
-        ei_free(w1);
-        ei_free(w2);
+        for (size_t row = 0; row < rows; row += lanes) {
+            size_t lane_rows = rows - row < lanes ? rows - row : lanes;
+            if (lane_rows == 1) {
+                butterworth_filter_t row_filter = *filter;
+                butterworth_filter_reset(&row_filter);
+                butterworth_filter_apply(&row_filter, buffer + (row * cols), buffer + (row * cols), cols);
+            }
+            else if (filter->is_high_pass) {
+                butterworth_filter_apply_lanes<true>(filter, buffer + (row * cols), lane_rows, cols);
+            }
+            else {
+                butterworth_filter_apply_lanes<false>(filter, buffer + (row * cols), lane_rows, cols);
+            }
+        }
+#else
+        butterworth_filter_t row_filter = *filter;
+
+        for (size_t row = 0; row < rows; row++) {
+            butterworth_filter_reset(&row_filter);
+            butterworth_filter_apply(&row_filter, buffer + (row * cols), buffer + (row * cols), cols);
+        }
+#endif
     }
 
     /**
-     * The Butterworth filter has maximally flat frequency response in the passband.
-     * @param filter_order Even filter order (between 2..8)
-     * @param sampling_freq Sample frequency of the signal
-     * @param cutoff_freq Cut-off frequency of the signal
-     * @param src Source array
-     * @param dest Destination array
-     * @param size Size of both source and destination arrays
+     * Filter with the coefficients for a config, kept between calls so they're only
+     * calculated when the config changes (per thread if EIDSP_CACHE_THREAD_LOCAL is set)
+     * @param filter Out, filter with the coefficients and a cleared state
+     * @returns EIDSP_OK if OK
      */
-    static void butterworth_highpass(
+    static int get_butterworth_filter(
+        butterworth_filter_t *filter,
         int filter_order,
         float sampling_freq,
         float cutoff_freq,
+        bool is_high_pass)
+    {
+#if EIDSP_CACHE_THREAD_LOCAL == 1
+        static thread_local butterworth_filter_t cached = { };
+#else
+        static butterworth_filter_t cached = { };
+#endif
+        EI_TRY(butterworth_filter_init(&cached, filter_order, sampling_freq, cutoff_freq, is_high_pass));
+        *filter = cached;
+        return EIDSP_OK;
+    }
+
+    /**
+     * Butterworth filter with the order and type fixed at compile time. Same output as
+     * butterworth_filter_apply, but the state is kept on the stack and the
+     * loop over the sections can be unrolled. Coefficients come from butterworth_coefficients,
+     * so they can be calculated once for all axes.
+     * @param A Gain per section (FILTER_ORDER / 2 elements)
+     * @param d1 First feedback coefficient per section
+     * @param d2 Second feedback coefficient per section
+     * @param src Source array
+     * @param dest Destination array (can be the same as src)
+     * @param size Size of both source and destination arrays
+     */
+    template<int FILTER_ORDER, bool IS_HIGH_PASS>
+    static void butterworth_filter(
+        const float *A,
+        const float *d1,
+        const float *d2,
         const float *src,
         float *dest,
         size_t size)
     {
-        int n_steps = filter_order / 2;
-        float a = tan(M_PI * cutoff_freq / sampling_freq);
-        float a2 = pow(a, 2);
-        float *A = (float*)ei_calloc(n_steps, sizeof(float));
-        float *d1 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *d2 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w0 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w1 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w2 = (float*)ei_calloc(n_steps, sizeof(float));
-
-        // Calculate the filter parameters
-        for (int ix = 0; ix < n_steps; ix++) {
-            float r = sin(M_PI * ((2.0 * ix) + 1.0) / (2.0 * filter_order));
-            sampling_freq = a2 + (2.0 * a * r) + 1.0;
-            A[ix] = 1.0f / sampling_freq;
-            d1[ix] = 2.0 * (1 - a2) / sampling_freq;
-            d2[ix] = -(a2 - (2.0 * a * r) + 1.0) / sampling_freq;
-        }
+        static_assert(FILTER_ORDER > 0 && FILTER_ORDER % 2 == 0, "Filter order should be even");
+
+        constexpr int n_steps = FILTER_ORDER / 2;
+        float w0[n_steps] = { 0 };
+        float w1[n_steps] = { 0 };
+        float w2[n_steps] = { 0 };
 
-        // Apply the filter
         for (size_t sx = 0; sx < size; sx++) {
             dest[sx] = src[sx];
 
             for (int i = 0; i < n_steps; i++) {
                 w0[i] = d1[i] * w1[i] + d2[i] * w2[i] + dest[sx];
-                dest[sx] = A[i] * (w0[i] - (2.0 * w1[i]) + w2[i]);
+                if (IS_HIGH_PASS) {
+                    dest[sx] = A[i] * (w0[i] - (2.0 * w1[i]) + w2[i]);
+                }
+                else {
+                    dest[sx] = A[i] * (w0[i] + (2.0 * w1[i]) + w2[i]);
+                }
                 w2[i] = w1[i];
                 w1[i] = w0[i];
             }
         }
-
-        ei_free(A);
-        ei_free(d1);
-        ei_free(d2);
-        ei_free(w0);
-        ei_free(w1);
-        ei_free(w2);
     }
 
 } // namespace filters
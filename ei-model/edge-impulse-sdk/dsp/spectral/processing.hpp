@@ -101,21 +101,17 @@ namespace processing {
      * @param filter_order
      * @returns 0 when successful
      */
-    static int butterworth_lowpass_filter(
+    __attribute__((unused)) static int butterworth_lowpass_filter(
         matrix_t *matrix,
         float sampling_frequency,
         float filter_cutoff,
         uint8_t filter_order)
     {
-        for (size_t row = 0; row < matrix->rows; row++) {
-            filters::butterworth_lowpass(
-                filter_order,
-                sampling_frequency,
-                filter_cutoff,
-                matrix->buffer + (row * matrix->cols),
-                matrix->buffer + (row * matrix->cols),
-                matrix->cols);
-        }
+        filters::butterworth_filter_t filter;
+        EI_TRY(filters::get_butterworth_filter(
+            &filter, filter_order, sampling_frequency, filter_cutoff, false));
+
+        filters::butterworth_filter_apply_rows(&filter, matrix->buffer, matrix->rows, matrix->cols);
 
         return EIDSP_OK;
     }
@@ -130,21 +126,17 @@ namespace processing {
      * @param filter_order
      * @returns 0 when successful
      */
-    static int butterworth_highpass_filter(
+    __attribute__((unused)) static int butterworth_highpass_filter(
         matrix_t *matrix,
         float sampling_frequency,
         float filter_cutoff,
         uint8_t filter_order)
     {
-        for (size_t row = 0; row < matrix->rows; row++) {
-            filters::butterworth_highpass(
-                filter_order,
-                sampling_frequency,
-                filter_cutoff,
-                matrix->buffer + (row * matrix->cols),
-                matrix->buffer + (row * matrix->cols),
-                matrix->cols);
-        }
+        filters::butterworth_filter_t filter;
+        EI_TRY(filters::get_butterworth_filter(
+            &filter, filter_order, sampling_frequency, filter_cutoff, true));
+
+        filters::butterworth_filter_apply_rows(&filter, matrix->buffer, matrix->rows, matrix->cols);
 
         return EIDSP_OK;
     }
@@ -223,7 +215,7 @@ namespace processing {
      * @param threshold Minimum threshold (default: 0.1)
      * @returns
      */
-    static int find_fft_peaks(
+    __attribute__((unused)) static int find_fft_peaks(
         matrix_t *fft_matrix,
         matrix_t *output_matrix,
         float sampling_freq,
@@ -480,6 +472,89 @@ namespace processing {
 
         return EIDSP_OK;
     }
+
+    /**
+     * Subtract the mean from a row, and in the same pass sum the 2nd, 3rd and 4th power
+     * of the mean subtracted values (for RMS, skewness and kurtosis). Replaces
+     * subtract_mean + numpy::rms + a separate skew / kurtosis loop.
+     * With EIDSP_SPECTRAL_MOMENTS_VECTORIZED the sums are split over 4 independent
+     * accumulators, so the compiler can vectorize the loops (summation order differs
+     * slightly from the sequential version).
+     * The sequential version matches the plain C subtract_mean / numpy::rms bit for bit.
+     * With EIDSP_USE_CMSIS_DSP those used arm_mean_f32 / arm_rms_f32, which sum in a
+     * different order, so features differ from that build in the last bits.
+     * @param data Row, the mean is subtracted in place
+     * @param size Number of values in the row
+     * @param power_sums Out: sum of x^2, x^3 and x^4
+     */
+    __attribute__((unused)) static void subtract_mean_and_sum_powers(float *data, size_t size, float power_sums[3]) {
+        power_sums[0] = power_sums[1] = power_sums[2] = 0.0f;
+        if (size == 0) {
+            return;
+        }
+
+#if EIDSP_SPECTRAL_MOMENTS_VECTORIZED == 1
+        float acc[4] = { 0 }, acc2[4] = { 0 }, acc3[4] = { 0 }, acc4[4] = { 0 };
+        const size_t size_4 = size & ~static_cast<size_t>(3);
+
+        for (size_t ix = 0; ix < size_4; ix += 4) {
+            for (size_t lane = 0; lane < 4; lane++) {
+                acc[lane] += data[ix + lane];
+            }
+        }
+        float sum = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+        for (size_t ix = size_4; ix < size; ix++) {
+            sum += data[ix];
+        }
+        const float mean = sum / size;
+
+        for (size_t ix = 0; ix < size_4; ix += 4) {
+            for (size_t lane = 0; lane < 4; lane++) {
+                float v = data[ix + lane] - mean;
+                data[ix + lane] = v;
+                float v2 = v * v;
+                acc2[lane] += v2;
+                acc3[lane] += v2 * v;
+                acc4[lane] += v2 * v2;
+            }
+        }
+        power_sums[0] = (acc2[0] + acc2[1]) + (acc2[2] + acc2[3]);
+        power_sums[1] = (acc3[0] + acc3[1]) + (acc3[2] + acc3[3]);
+        power_sums[2] = (acc4[0] + acc4[1]) + (acc4[2] + acc4[3]);
+        for (size_t ix = size_4; ix < size; ix++) {
+            float v = data[ix] - mean;
+            data[ix] = v;
+            power_sums[0] += v * v;
+            power_sums[1] += v * v * v;
+            power_sums[2] += v * v * v * v;
+        }
+#else
+        float mean;
+#if EIDSP_USE_CMSIS_DSP
+        arm_mean_f32(data, size, &mean);
+#else
+        float sum = 0.0f;
+        for (size_t ix = 0; ix < size; ix++) {
+            sum += data[ix];
+        }
+        mean = sum / size;
+#endif
+
+        // same operations, in the same order, as the separate passes
+        float sum2 = 0.0f, sum3 = 0.0f, sum4 = 0.0f;
+        for (size_t ix = 0; ix < size; ix++) {
+            float v = data[ix] - mean;
+            data[ix] = v;
+            sum2 += v * v;
+            float v3 = v * v * v;
+            sum3 += v3;
+            sum4 += v3 * v;
+        }
+        power_sums[0] = sum2;
+        power_sums[1] = sum3;
+        power_sums[2] = sum4;
+#endif
+    }
 } // namespace processing
 } // namespace spectral
 } // namespace ei
@@ -26,6 +26,15 @@
 
 #include "processing.hpp"
 #include "wavelet_coeff.hpp"
+#include "../config.hpp"
+
+#if EIDSP_WAVELET_VECTORIZED == 1
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#endif // EIDSP_WAVELET_VECTORIZED == 1
 
 namespace ei {
 namespace spectral {
@@ -41,245 +50,532 @@ inline float dot(const float *x, const float *y, size_t sz)
     return sum;
 }
 
-inline void histo(const fvec &x, size_t nbins, fvec &h, bool normalize = false)
+inline void histo(const float *x, size_t nx, size_t nbins, float *h, bool normalize = false)
 {
-    float min = *std::min_element(x.begin(), x.end());
-    float max = *std::max_element(x.begin(), x.end());
+    float min = *std::min_element(x, x + nx);
+    float max = *std::max_element(x, x + nx);
     float step = (max - min) / nbins;
-    h.resize(nbins);
-    for (size_t i = 0; i < x.size(); i++) {
+    for (size_t i = 0; i < nbins; i++) {
+        h[i] = 0.0f;
+    }
+    for (size_t i = 0; i < nx; i++) {
         size_t bin = (x[i] - min) / step;
         if (bin >= nbins)
             bin = nbins - 1;
         h[bin]++;
     }
     if (normalize) {
-        float s = numpy::sum(h.data(), h.size());
+        float s = numpy::sum(h, nbins);
         for (size_t i = 0; i < nbins; i++) {
             h[i] /= s;
         }
     }
 }
 
-class wavelet {
+inline void histo(const fvec &x, size_t nbins, fvec &h, bool normalize = false)
+{
+    h.resize(nbins);
+    histo(x.data(), x.size(), nbins, h.data(), normalize);
+}
 
+class wavelet {
+public:
     static constexpr size_t NUM_FEATHERS_PER_COMP = 14;
-
+    static constexpr size_t MAX_FILTER_SIZE = 20;
+    static constexpr size_t ENTROPY_BINS = 100;
+
+    /**
+     * Decomposition filters of a wavelet, reversed so they can be applied with a dot product
+     */
+    typedef struct {
+        size_t size;
+        float h[MAX_FILTER_SIZE]; // low pass (approximation)
+        float g[MAX_FILTER_SIZE]; // high pass (detail)
+    } wavelet_filter_t;
+
+    /**
+     * Everything needed to run wavedec on a signal of a fixed size. The filter is resolved
+     * and all buffers for all levels are allocated (in one block) once in wavelet_workspace_init,
+     * so calculating the features of a signal does not allocate.
+     */
+    typedef struct {
+        wavelet_filter_t filter;
+        int level;
+        size_t signal_size;
+        float *buffer; // owns all of the buffers below
+        float *approx[2]; // approximation coefficients, ping-pong between input and output of a level
+        float *detail; // detail coefficients of the current level
+        float *scratch; // sorted copy of the coefficients / entropy histogram
+    } wavelet_workspace_t;
+
+private:
     template <size_t wave_size>
-    static void get_filter(const std::array<std::array<float, wave_size>, 2> wav, fvec &h, fvec &g)
+    static bool get_filter(const std::array<std::array<float, wave_size>, 2> &wav, wavelet_filter_t *filter)
     {
-        size_t n = wav[0].size();
-        h.resize(n);
-        g.resize(n);
-        for (size_t i = 0; i < n; i++) {
-            h[i] = wav[0][n - i - 1];
-            g[i] = wav[1][n - i - 1];
+        static_assert(wave_size <= MAX_FILTER_SIZE, "wave_size should be <= MAX_FILTER_SIZE");
+
+        filter->size = wave_size;
+        for (size_t i = 0; i < wave_size; i++) {
+            filter->h[i] = wav[0][wave_size - i - 1];
+            filter->g[i] = wav[1][wave_size - i - 1];
         }
+        return true;
     }
 
-    static void find_filter(const char *wav, fvec &h, fvec &g)
+    static bool find_filter(const char *wav, wavelet_filter_t *filter)
     {
-        if (strcmp(wav, "bior1.3") == 0) get_filter<6>(bior1p3, h, g);
-        else if (strcmp(wav, "bior1.5") == 0) get_filter<10>(bior1p5, h, g);
-        else if (strcmp(wav, "bior2.2") == 0) get_filter<6>(bior2p2, h, g);
-        else if (strcmp(wav, "bior2.4") == 0) get_filter<10>(bior2p4, h, g);
-        else if (strcmp(wav, "bior2.6") == 0) get_filter<14>(bior2p6, h, g);
-        else if (strcmp(wav, "bior2.8") == 0) get_filter<18>(bior2p8, h, g);
-        else if (strcmp(wav, "bior3.1") == 0) get_filter<4>(bior3p1, h, g);
-        else if (strcmp(wav, "bior3.3") == 0) get_filter<8>(bior3p3, h, g);
-        else if (strcmp(wav, "bior3.5") == 0) get_filter<12>(bior3p5, h, g);
-        else if (strcmp(wav, "bior3.7") == 0) get_filter<16>(bior3p7, h, g);
-        else if (strcmp(wav, "bior3.9") == 0) get_filter<20>(bior3p9, h, g);
-        else if (strcmp(wav, "bior4.4") == 0) get_filter<10>(bior4p4, h, g);
-        else if (strcmp(wav, "bior5.5") == 0) get_filter<12>(bior5p5, h, g);
-        else if (strcmp(wav, "bior6.8") == 0) get_filter<18>(bior6p8, h, g);
-        else if (strcmp(wav, "coif1") == 0) get_filter<6>(coif1, h, g);
-        else if (strcmp(wav, "coif2") == 0) get_filter<12>(coif2, h, g);
-        else if (strcmp(wav, "coif3") == 0) get_filter<18>(coif3, h, g);
-        else if (strcmp(wav, "db2") == 0) get_filter<4>(db2, h, g);
-        else if (strcmp(wav, "db3") == 0) get_filter<6>(db3, h, g);
-        else if (strcmp(wav, "db4") == 0) get_filter<8>(db4, h, g);
-        else if (strcmp(wav, "db5") == 0) get_filter<10>(db5, h, g);
-        else if (strcmp(wav, "db6") == 0) get_filter<12>(db6, h, g);
-        else if (strcmp(wav, "db7") == 0) get_filter<14>(db7, h, g);
-        else if (strcmp(wav, "db8") == 0) get_filter<16>(db8, h, g);
-        else if (strcmp(wav, "db9") == 0) get_filter<18>(db9, h, g);
-        else if (strcmp(wav, "db10") == 0) get_filter<20>(db10, h, g);
-        else if (strcmp(wav, "haar") == 0) get_filter<2>(haar, h, g);
-        else if (strcmp(wav, "rbio1.3") == 0) get_filter<6>(rbio1p3, h, g);
-        else if (strcmp(wav, "rbio1.5") == 0) get_filter<10>(rbio1p5, h, g);
-        else if (strcmp(wav, "rbio2.2") == 0) get_filter<6>(rbio2p2, h, g);
-        else if (strcmp(wav, "rbio2.4") == 0) get_filter<10>(rbio2p4, h, g);
-        else if (strcmp(wav, "rbio2.6") == 0) get_filter<14>(rbio2p6, h, g);
-        else if (strcmp(wav, "rbio2.8") == 0) get_filter<18>(rbio2p8, h, g);
-        else if (strcmp(wav, "rbio3.1") == 0) get_filter<4>(rbio3p1, h, g);
-        else if (strcmp(wav, "rbio3.3") == 0) get_filter<8>(rbio3p3, h, g);
-        else if (strcmp(wav, "rbio3.5") == 0) get_filter<12>(rbio3p5, h, g);
-        else if (strcmp(wav, "rbio3.7") == 0) get_filter<16>(rbio3p7, h, g);
-        else if (strcmp(wav, "rbio3.9") == 0) get_filter<20>(rbio3p9, h, g);
-        else if (strcmp(wav, "rbio4.4") == 0) get_filter<10>(rbio4p4, h, g);
-        else if (strcmp(wav, "rbio5.5") == 0) get_filter<12>(rbio5p5, h, g);
-        else if (strcmp(wav, "rbio6.8") == 0) get_filter<18>(rbio6p8, h, g);
-        else if (strcmp(wav, "sym2") == 0) get_filter<4>(sym2, h, g);
-        else if (strcmp(wav, "sym3") == 0) get_filter<6>(sym3, h, g);
-        else if (strcmp(wav, "sym4") == 0) get_filter<8>(sym4, h, g);
-        else if (strcmp(wav, "sym5") == 0) get_filter<10>(sym5, h, g);
-        else if (strcmp(wav, "sym6") == 0) get_filter<12>(sym6, h, g);
-        else if (strcmp(wav, "sym7") == 0) get_filter<14>(sym7, h, g);
-        else if (strcmp(wav, "sym8") == 0) get_filter<16>(sym8, h, g);
-        else if (strcmp(wav, "sym9") == 0) get_filter<18>(sym9, h, g);
-        else if (strcmp(wav, "sym10") == 0) get_filter<20>(sym10, h, g);
-        else assert(0); // wavelet not in the list
+        if (strcmp(wav, "bior1.3") == 0) return get_filter<6>(bior1p3, filter);
+        else if (strcmp(wav, "bior1.5") == 0) return get_filter<10>(bior1p5, filter);
+        else if (strcmp(wav, "bior2.2") == 0) return get_filter<6>(bior2p2, filter);
+        else if (strcmp(wav, "bior2.4") == 0) return get_filter<10>(bior2p4, filter);
+        else if (strcmp(wav, "bior2.6") == 0) return get_filter<14>(bior2p6, filter);
+        else if (strcmp(wav, "bior2.8") == 0) return get_filter<18>(bior2p8, filter);
+        else if (strcmp(wav, "bior3.1") == 0) return get_filter<4>(bior3p1, filter);
+        else if (strcmp(wav, "bior3.3") == 0) return get_filter<8>(bior3p3, filter);
+        else if (strcmp(wav, "bior3.5") == 0) return get_filter<12>(bior3p5, filter);
+        else if (strcmp(wav, "bior3.7") == 0) return get_filter<16>(bior3p7, filter);
+        else if (strcmp(wav, "bior3.9") == 0) return get_filter<20>(bior3p9, filter);
+        else if (strcmp(wav, "bior4.4") == 0) return get_filter<10>(bior4p4, filter);
+        else if (strcmp(wav, "bior5.5") == 0) return get_filter<12>(bior5p5, filter);
+        else if (strcmp(wav, "bior6.8") == 0) return get_filter<18>(bior6p8, filter);
+        else if (strcmp(wav, "coif1") == 0) return get_filter<6>(coif1, filter);
+        else if (strcmp(wav, "coif2") == 0) return get_filter<12>(coif2, filter);
+        else if (strcmp(wav, "coif3") == 0) return get_filter<18>(coif3, filter);
+        else if (strcmp(wav, "db2") == 0) return get_filter<4>(db2, filter);
+        else if (strcmp(wav, "db3") == 0) return get_filter<6>(db3, filter);
+        else if (strcmp(wav, "db4") == 0) return get_filter<8>(db4, filter);
+        else if (strcmp(wav, "db5") == 0) return get_filter<10>(db5, filter);
+        else if (strcmp(wav, "db6") == 0) return get_filter<12>(db6, filter);
+        else if (strcmp(wav, "db7") == 0) return get_filter<14>(db7, filter);
+        else if (strcmp(wav, "db8") == 0) return get_filter<16>(db8, filter);
+        else if (strcmp(wav, "db9") == 0) return get_filter<18>(db9, filter);
+        else if (strcmp(wav, "db10") == 0) return get_filter<20>(db10, filter);
+        else if (strcmp(wav, "haar") == 0) return get_filter<2>(haar, filter);
+        else if (strcmp(wav, "rbio1.3") == 0) return get_filter<6>(rbio1p3, filter);
+        else if (strcmp(wav, "rbio1.5") == 0) return get_filter<10>(rbio1p5, filter);
+        else if (strcmp(wav, "rbio2.2") == 0) return get_filter<6>(rbio2p2, filter);
+        else if (strcmp(wav, "rbio2.4") == 0) return get_filter<10>(rbio2p4, filter);
+        else if (strcmp(wav, "rbio2.6") == 0) return get_filter<14>(rbio2p6, filter);
+        else if (strcmp(wav, "rbio2.8") == 0) return get_filter<18>(rbio2p8, filter);
+        else if (strcmp(wav, "rbio3.1") == 0) return get_filter<4>(rbio3p1, filter);
+        else if (strcmp(wav, "rbio3.3") == 0) return get_filter<8>(rbio3p3, filter);
+        else if (strcmp(wav, "rbio3.5") == 0) return get_filter<12>(rbio3p5, filter);
+        else if (strcmp(wav, "rbio3.7") == 0) return get_filter<16>(rbio3p7, filter);
+        else if (strcmp(wav, "rbio3.9") == 0) return get_filter<20>(rbio3p9, filter);
+        else if (strcmp(wav, "rbio4.4") == 0) return get_filter<10>(rbio4p4, filter);
+        else if (strcmp(wav, "rbio5.5") == 0) return get_filter<12>(rbio5p5, filter);
+        else if (strcmp(wav, "rbio6.8") == 0) return get_filter<18>(rbio6p8, filter);
+        else if (strcmp(wav, "sym2") == 0) return get_filter<4>(sym2, filter);
+        else if (strcmp(wav, "sym3") == 0) return get_filter<6>(sym3, filter);
+        else if (strcmp(wav, "sym4") == 0) return get_filter<8>(sym4, filter);
+        else if (strcmp(wav, "sym5") == 0) return get_filter<10>(sym5, filter);
+        else if (strcmp(wav, "sym6") == 0) return get_filter<12>(sym6, filter);
+        else if (strcmp(wav, "sym7") == 0) return get_filter<14>(sym7, filter);
+        else if (strcmp(wav, "sym8") == 0) return get_filter<16>(sym8, filter);
+        else if (strcmp(wav, "sym9") == 0) return get_filter<18>(sym9, filter);
+        else if (strcmp(wav, "sym10") == 0) return get_filter<20>(sym10, filter);
+        return false; // wavelet not in the list
     }
 
-    static void calculate_entropy(const fvec &y, fvec &features)
+    static float calculate_entropy(const float *y, size_t ny, float *h)
     {
-        fvec h;
-        histo(y, 100, h, true);
+        histo(y, ny, ENTROPY_BINS, h, true);
         // entropy = -sum(prob * log(prob)
         float entropy = 0.0f;
-        for (size_t i = 0; i < h.size(); i++) {
+        for (size_t i = 0; i < ENTROPY_BINS; i++) {
             if (h[i] > 0.0f) {
                 entropy -= h[i] * log(h[i]);
             }
         }
-        features.push_back(entropy);
+        return entropy;
     }
 
-    static void calculate_statistics(const fvec &y, fvec &features, float mean)
+    static float *calculate_statistics(const float *y, size_t ny, float *sorted, float *features, float mean)
     {
-        fvec sorted = y;
-        std::sort(sorted.begin(), sorted.end());
-        features.push_back(sorted[sorted.size() * 0.05]);
-        features.push_back(sorted[sorted.size() * 0.25]);
-        features.push_back(sorted[sorted.size() * 0.75]);
-        features.push_back(sorted[sorted.size() * 0.95]);
-        features.push_back(sorted[sorted.size() * 0.5]);
-
-        matrix_t x(1, y.size(), const_cast<float *>(y.data()));
-        matrix_t out(1, 1);
-
-        features.push_back(mean);
+        memcpy(sorted, y, ny * sizeof(float));
+        std::sort(sorted, sorted + ny);
+        *features++ = sorted[(size_t)(ny * 0.05)];
+        *features++ = sorted[(size_t)(ny * 0.25)];
+        *features++ = sorted[(size_t)(ny * 0.75)];
+        *features++ = sorted[(size_t)(ny * 0.95)];
+        *features++ = sorted[(size_t)(ny * 0.5)];
+
+        matrix_t x(1, ny, const_cast<float *>(y));
+        float out_value;
+        matrix_t out(1, 1, &out_value);
+
+        *features++ = mean;
         if (numpy::stdev(&x, &out) == EIDSP_OK)
-            features.push_back(out.get_row_ptr(0)[0]);
-        features.push_back(numpy::variance(const_cast<float *>(y.data()), y.size()));
+            *features++ = out_value;
+        *features++ = numpy::variance(const_cast<float *>(y), ny);
         if (numpy::rms(&x, &out) == EIDSP_OK)
-            features.push_back(out.get_row_ptr(0)[0]);
+            *features++ = out_value;
         if (numpy::skew(&x, &out) == EIDSP_OK)
-            features.push_back(out.get_row_ptr(0)[0]);
+            *features++ = out_value;
         if (numpy::kurtosis(&x, &out) == EIDSP_OK)
-            features.push_back(out.get_row_ptr(0)[0]);
+            *features++ = out_value;
+        return features;
     }
 
-    static void calculate_crossings(const fvec &y, fvec &features, float mean)
+    static float *calculate_crossings(const float *y, size_t ny, float *features, float mean)
     {
         size_t zc = 0;
-        for (size_t i = 1; i < y.size(); i++) {
+        for (size_t i = 1; i < ny; i++) {
             if (y[i] * y[i - 1] < 0) {
                 zc++;
             }
         }
-        features.push_back(zc / (float)y.size());
+        *features++ = zc / (float)ny;
 
         size_t mc = 0;
-        for (size_t i = 1; i < y.size(); i++) {
+        for (size_t i = 1; i < ny; i++) {
             if ((y[i] - mean) * (y[i - 1] - mean) < 0) {
                 mc++;
             }
         }
-        features.push_back(mc / (float)y.size());
+        *features++ = mc / (float)ny;
+        return features;
     }
 
-    static void
-    dwt(const float *x, size_t nx, const float *h, const float *g, size_t nh, fvec &a, fvec &d)
+    /**
+     * Sample j of the symmetric padded input (the default mode in PyWavelet), which
+     * has nh - 2 mirrored samples on the left, and nh on the right.
+     */
+    static inline float symmetric_sample(const float *x, size_t nx, size_t nh, size_t j)
     {
-        assert(nh <= 20 && nh > 0 && nx > 0);
-        size_t nx_padded = nx + nh * 2 - 2;
-        fvec x_padded(nx_padded);
-
-        // symmetric padding (default in PyWavelet)
-        for (size_t i = 0; i < nh - 2; i++)
-            x_padded[i] = x[nh - 3 - i];
-        for (size_t i = 0; i < nx; i++)
-            x_padded[i + nh - 2] = x[i];
-        for (size_t i = 0; i < nh; i++)
-            x_padded[i + nx + nh - 2] = x[nx - 1 - i];
-
-        size_t ny = (nx + nh - 1) / 2;
-        a.resize(ny);
-        d.resize(ny);
-
-        // decimate and filter
-        const float *xx = x_padded.data();
-        for (size_t i = 0; i < ny; i++) {
-            a[i] = dot(xx + 2 * i, h, nh);
-            d[i] = dot(xx + 2 * i, g, nh);
+        if (j < nh - 2) {
+            return x[nh - 3 - j];
         }
+        if (j < nx + nh - 2) {
+            return x[j - (nh - 2)];
+        }
+        return x[2 * nx + nh - 3 - j];
     }
 
-    static void extract_features(fvec& y, fvec &features)
+#if EIDSP_WAVELET_VECTORIZED == 1
+    // 4 consecutive dwt coefficients, one per lane, in a SIMD register if available
+#if defined(__SSE2__) || defined(_M_X64)
+    struct dwt_lanes_t {
+        static constexpr size_t lanes = 4;
+        typedef __m128 vec_t;
+        // even samples p[0], p[2], .. in even, odd samples p[1], p[3], .. in odd
+        static void load_even_odd(const float *p, vec_t *even, vec_t *odd) {
+            __m128 lo = _mm_loadu_ps(p);
+            __m128 hi = _mm_loadu_ps(p + 4);
+            *even = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+            *odd = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+        }
+        static void store(float *p, vec_t v) { _mm_storeu_ps(p, v); }
+        static vec_t set1(float v) { return _mm_set1_ps(v); }
+        static vec_t mul_add(vec_t acc, vec_t a, vec_t b) { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+    };
+#elif defined(__ARM_NEON)
+    struct dwt_lanes_t {
+        static constexpr size_t lanes = 4;
+        typedef float32x4_t vec_t;
+        static void load_even_odd(const float *p, vec_t *even, vec_t *odd) {
+            float32x4x2_t v = vld2q_f32(p);
+            *even = v.val[0];
+            *odd = v.val[1];
+        }
+        static void store(float *p, vec_t v) { vst1q_f32(p, v); }
+        static vec_t set1(float v) { return vdupq_n_f32(v); }
+        // no vmlaq_f32, the multiply is rounded before the add just like in dot()
+        static vec_t mul_add(vec_t acc, vec_t a, vec_t b) { return vaddq_f32(acc, vmulq_f32(a, b)); }
+    };
+#else
+    struct dwt_lanes_t {
+        static constexpr size_t lanes = 4;
+        typedef struct { float v[4]; } vec_t;
+        static void load_even_odd(const float *p, vec_t *even, vec_t *odd) {
+            for (size_t i = 0; i < 4; i++) { even->v[i] = p[2 * i]; odd->v[i] = p[2 * i + 1]; }
+        }
+        static void store(float *p, vec_t a) { for (size_t i = 0; i < 4; i++) p[i] = a.v[i]; }
+        static vec_t set1(float v) { vec_t r; for (size_t i = 0; i < 4; i++) r.v[i] = v; return r; }
+        static vec_t mul_add(vec_t acc, vec_t a, vec_t b) { for (size_t i = 0; i < 4; i++) acc.v[i] += a.v[i] * b.v[i]; return acc; }
+    };
+#endif
+#endif // EIDSP_WAVELET_VECTORIZED == 1
+
+    /**
+     * Single level of the decomposition, approximation and detail coefficients in one pass.
+     * Coefficients that only see x are read straight from x (in polyphase form, the even
+     * taps hit the even samples and the odd taps the odd ones), only the few coefficients
+     * at the symmetric edges go through symmetric_sample. x should not overlap a or d.
+     * @returns Number of coefficients, (nx + nh - 1) / 2
+     */
+    static size_t dwt(
+        const float *x,
+        size_t nx,
+        const wavelet_filter_t *filter,
+        float *a,
+        float *d)
     {
-        matrix_t x(1, y.size(), const_cast<float *>(y.data()));
-        matrix_t out(1, 1);
-        if (numpy::mean(&x, &out) != EIDSP_OK)
-            assert(0);
-        float mean = out.get_row_ptr(0)[0];
-
-        calculate_entropy(y, features);
-        calculate_crossings(y, features, mean);
-        calculate_statistics(y, features, mean);
+        const size_t nh = filter->size;
+        const float *h = filter->h;
+        const float *g = filter->g;
+        const size_t ny = (nx + nh - 1) / 2;
+
+        // coefficient i covers padded samples 2i .. 2i + nh - 1, i.e. x[2i - (nh - 2)] .. x[2i + 1]
+        const size_t inner_start = (nh - 2) / 2;
+        size_t inner_end = nx / 2;
+        if (inner_end < inner_start) {
+            inner_end = inner_start;
+        }
+
+        size_t i = 0;
+        for (; i < inner_start && i < ny; i++) {
+            float sum_a = 0.0f;
+            float sum_d = 0.0f;
+            for (size_t k = 0; k < nh; k++) {
+                float v = symmetric_sample(x, nx, nh, 2 * i + k);
+                sum_a += v * h[k];
+                sum_d += v * g[k];
+            }
+            a[i] = sum_a;
+            d[i] = sum_d;
+        }
+
+#if EIDSP_WAVELET_VECTORIZED == 1
+        typedef dwt_lanes_t V;
+
+        for (; i + V::lanes <= inner_end; i += V::lanes) {
+            const float *xx = x + 2 * i - (nh - 2);
+            V::vec_t sum_a = V::set1(0.0f);
+            V::vec_t sum_d = V::set1(0.0f);
+            // filters are always of even length
+            for (size_t k = 0; k < nh; k += 2) {
+                V::vec_t even, odd;
+                V::load_even_odd(xx + k, &even, &odd);
+                sum_a = V::mul_add(sum_a, even, V::set1(h[k]));
+                sum_d = V::mul_add(sum_d, even, V::set1(g[k]));
+                sum_a = V::mul_add(sum_a, odd, V::set1(h[k + 1]));
+                sum_d = V::mul_add(sum_d, odd, V::set1(g[k + 1]));
+            }
+            V::store(a + i, sum_a);
+            V::store(d + i, sum_d);
+        }
+#endif // EIDSP_WAVELET_VECTORIZED == 1
+
+        for (; i < inner_end; i++) {
+            const float *xx = x + 2 * i - (nh - 2);
+            float sum_a = 0.0f;
+            float sum_d = 0.0f;
+            for (size_t k = 0; k < nh; k++) {
+                sum_a += xx[k] * h[k];
+                sum_d += xx[k] * g[k];
+            }
+            a[i] = sum_a;
+            d[i] = sum_d;
+        }
+
+        for (; i < ny; i++) {
+            float sum_a = 0.0f;
+            float sum_d = 0.0f;
+            for (size_t k = 0; k < nh; k++) {
+                float v = symmetric_sample(x, nx, nh, 2 * i + k);
+                sum_a += v * h[k];
+                sum_d += v * g[k];
+            }
+            a[i] = sum_a;
+            d[i] = sum_d;
+        }
+
+        return ny;
     }
 
-    static void
-    wavedec_features(const float *x, int len, const char *wav, int level, fvec &features)
+    static void extract_features(const float *y, size_t ny, float *scratch, float *features)
     {
-        assert(level > 0 && level < 8);
+        matrix_t x(1, ny, const_cast<float *>(y));
+        float mean_value;
+        matrix_t out(1, 1, &mean_value);
+        numpy::mean(&x, &out);
+
+        *features++ = calculate_entropy(y, ny, scratch);
+        features = calculate_crossings(y, ny, features, mean_value);
+        calculate_statistics(y, ny, scratch, features, mean_value);
+    }
 
-        fvec h;
-        fvec g;
-        find_filter(wav, h, g);
+    static bool check_min_size(int len, int level)
+    {
+        int min_size = 32 * (1 << level);
+        return (len >= min_size);
+    }
 
-        features.clear();
-        fvec a;
-        fvec d;
-        dwt(x, len, h.data(), g.data(), h.size(), a, d);
-        extract_features(d, features);
+public:
+    /**
+     * Resolve the filter and allocate all buffers for wavelet_workspace_features
+     * @param workspace Workspace to initialize, free with wavelet_workspace_free
+     * @param wav Name of the wavelet (e.g. "db4")
+     * @param level Decomposition level (1..7)
+     * @param signal_size Number of samples in the signal
+     * @returns 0 if OK
+     */
+    static int wavelet_workspace_init(
+        wavelet_workspace_t *workspace,
+        const char *wav,
+        int level,
+        size_t signal_size)
+    {
+        memset(workspace, 0, sizeof(wavelet_workspace_t));
 
-        for (int l = 1; l < level; l++) {
-            dwt(a.data(), a.size(), h.data(), g.data(), h.size(), a, d);
-            extract_features(d, features);
+        if (level < 1 || level > 7) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+        if (!find_filter(wav, &workspace->filter)) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
         }
 
-        extract_features(a, features);
-
-        for (int l = 0; l <= level / 2; l++) { // reverse order to match python results.
-            for (int i = 0; i < (int)NUM_FEATHERS_PER_COMP; i++) {
-                std::swap(
-                    features[l * NUM_FEATHERS_PER_COMP + i],
-                    features[(level - l) * NUM_FEATHERS_PER_COMP + i]);
+        // the symmetric edges of every level mirror at most nh samples of its input
+        const size_t nh = workspace->filter.size;
+        size_t level_size = signal_size;
+        for (int l = 0; l < level; l++) {
+            if (level_size < nh) {
+                EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
             }
+            level_size = (level_size + nh - 1) / 2;
+        }
+
+        // the first level is the largest, every next level reuses the same buffers
+        const size_t coeff_size = (signal_size + nh - 1) / 2;
+        size_t scratch_size = coeff_size;
+        if (scratch_size < ENTROPY_BINS) {
+            scratch_size = ENTROPY_BINS;
+        }
+
+        workspace->buffer = (float *)ei_calloc(
+            coeff_size * 3 + scratch_size, sizeof(float));
+        if (!workspace->buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        workspace->level = level;
+        workspace->signal_size = signal_size;
+        workspace->approx[0] = workspace->buffer;
+        workspace->approx[1] = workspace->approx[0] + coeff_size;
+        workspace->detail = workspace->approx[1] + coeff_size;
+        workspace->scratch = workspace->detail + coeff_size;
+
+        return EIDSP_OK;
+    }
+
+    static void wavelet_workspace_free(wavelet_workspace_t *workspace)
+    {
+        if (workspace->buffer) {
+            ei_free(workspace->buffer);
         }
+        memset(workspace, 0, sizeof(wavelet_workspace_t));
+    }
+
+#if EIDSP_WAVELET_WORKSPACE_CACHE == 1
+    /**
+     * Workspace kept between calls to extract_wavelet_features, keyed by the wavelet name
+     * (names that don't fit in wav are never matched, so get a new workspace every call)
+     */
+    typedef struct {
+        wavelet_workspace_t workspace;
+        char wav[16];
+    } wavelet_workspace_cache_t;
+
+    static wavelet_workspace_cache_t *get_wavelet_workspace_cache()
+    {
+#if EIDSP_CACHE_THREAD_LOCAL == 1
+        // every thread has its own workspace, which is freed when the thread exits
+        struct thread_cache_t {
+            wavelet_workspace_cache_t cache;
+            ~thread_cache_t() { wavelet_workspace_free(&cache.workspace); }
+        };
+        static thread_local thread_cache_t thread_cache;
+        return &thread_cache.cache;
+#else
+        static wavelet_workspace_cache_t cache = { };
+        return &cache;
+#endif
     }
 
-    static int dwt_features(const float *x, int len, const char *wav, int level, fvec &features)
+    /**
+     * Get the cached workspace for a wavelet, level and signal size, (re)initializing it
+     * if any of them changed since the last call
+     * @param workspace Out, workspace owned by the cache (don't free)
+     * @returns 0 if OK
+     */
+    static int get_wavelet_workspace(
+        wavelet_workspace_t **workspace,
+        const char *wav,
+        int level,
+        size_t signal_size)
     {
-        assert(level <= 7);
+        wavelet_workspace_cache_t *cache = get_wavelet_workspace_cache();
 
-        assert(features.size() == 0); // make sure features is empty
-        features.reserve((level + 1) * NUM_FEATHERS_PER_COMP);
+        if (!cache->workspace.buffer || cache->workspace.level != level ||
+                cache->workspace.signal_size != signal_size || strcmp(cache->wav, wav) != 0) {
+            wavelet_workspace_free(&cache->workspace);
+            cache->wav[0] = '\0';
 
-        wavedec_features(x, len, wav, level, features);
+            EI_TRY(wavelet_workspace_init(&cache->workspace, wav, level, signal_size));
+            if (strlen(wav) < sizeof(cache->wav)) {
+                strcpy(cache->wav, wav);
+            }
+        }
 
-        return features.size();
+        *workspace = &cache->workspace;
+        return EIDSP_OK;
     }
+#endif // EIDSP_WAVELET_WORKSPACE_CACHE == 1
 
-    static bool check_min_size(int len, int level)
+    /**
+     * Free the cached wavelet workspace (of this thread, if EIDSP_CACHE_THREAD_LOCAL is set)
+     */
+    static void clear_wavelet_workspace_cache()
     {
-        int min_size = 32 * (1 << level);
-        return (len >= min_size);
+#if EIDSP_WAVELET_WORKSPACE_CACHE == 1
+        wavelet_workspace_cache_t *cache = get_wavelet_workspace_cache();
+        wavelet_workspace_free(&cache->workspace);
+        cache->wav[0] = '\0';
+#endif
+    }
+
+    /**
+     * Number of features that wavelet_workspace_features writes
+     */
+    static size_t wavelet_workspace_feature_count(const wavelet_workspace_t *workspace)
+    {
+        return (workspace->level + 1) * NUM_FEATHERS_PER_COMP;
+    }
+
+    /**
+     * Multilevel decomposition (wavedec) of x, with the features of the approximation
+     * of the last level followed by the features of the details of every level, from the
+     * last level back to the first one (same order as the python implementation).
+     * @param workspace Initialized workspace
+     * @param x Signal (workspace->signal_size samples)
+     * @param features Out features (wavelet_workspace_feature_count values)
+     */
+    static void wavelet_workspace_features(
+        wavelet_workspace_t *workspace,
+        const float *x,
+        float *features)
+    {
+        const int level = workspace->level;
+        const float *input = x;
+        size_t n = workspace->signal_size;
+
+        for (int l = 1; l <= level; l++) {
+            // the approx of this level is the input of the next one, so alternate the buffers
+            float *approx = workspace->approx[l % 2];
+            n = dwt(input, n, &workspace->filter, approx, workspace->detail);
+            input = approx;
+
+            extract_features(
+                workspace->detail,
+                n,
+                workspace->scratch,
+                features + ((level - l + 1) * NUM_FEATHERS_PER_COMP));
+        }
+
+        extract_features(input, n, workspace->scratch, features);
     }
 
-public:
     static int extract_wavelet_features(
         matrix_t *input_matrix,
         matrix_t *output_matrix,
@@ -315,27 +611,36 @@ public:
 
         EI_TRY(processing::subtract_mean(input_matrix));
 
-        int out_idx = 0;
-        for (size_t row = 0; row < input_matrix->rows; row++) {
-            float *data_window = input_matrix->get_row_ptr(row);
-            size_t data_size = input_matrix->cols;
+        size_t data_size = input_matrix->cols;
+        if (!check_min_size(data_size, config->wavelet_level))
+            EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
 
-            if (!check_min_size(data_size, config->wavelet_level))
-                EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
+        const size_t num_features = (config->wavelet_level + 1) * NUM_FEATHERS_PER_COMP;
+        if (output_matrix->rows * output_matrix->cols != input_matrix->rows * num_features) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
 
-            fvec features;
-            size_t num_features = dwt_features(
-                data_window,
-                data_size,
-                config->wavelet,
-                config->wavelet_level,
-                features);
-
-            assert(num_features == output_matrix->cols / input_matrix->rows);
-            for (size_t i = 0; i < num_features; i++) {
-                output_matrix->buffer[out_idx++] = features[i];
-            }
+        // one workspace for all axes (and all levels)
+#if EIDSP_WAVELET_WORKSPACE_CACHE == 1
+        wavelet_workspace_t *workspace;
+        EI_TRY(get_wavelet_workspace(&workspace, config->wavelet, config->wavelet_level, data_size));
+#else
+        wavelet_workspace_t workspace_buffers;
+        wavelet_workspace_t *workspace = &workspace_buffers;
+        EI_TRY(wavelet_workspace_init(workspace, config->wavelet, config->wavelet_level, data_size));
+#endif
+
+        for (size_t row = 0; row < input_matrix->rows; row++) {
+            wavelet_workspace_features(
+                workspace,
+                input_matrix->get_row_ptr(row),
+                output_matrix->buffer + (row * num_features));
         }
+
+#if EIDSP_WAVELET_WORKSPACE_CACHE == 0
+        wavelet_workspace_free(workspace);
+#endif
+
         return EIDSP_OK;
     }
 };
@@ -163,6 +163,191 @@ public:
         return EIDSP_OK;
     }
 
+#if EIDSP_QUANTIZE_FILTERBANK
+    typedef uint8_t mel_filterbank_weight_t;
+#else
+    typedef float mel_filterbank_weight_t;
+#endif
+
+    typedef struct {
+        uint16_t start;     // first fft bin with a non-zero weight
+        uint16_t length;    // number of weights
+        uint32_t offset;    // index of the first weight in mel_filterbank_t::weights
+    } mel_filterbank_row_t;
+
+    /**
+     * Mel filterbank that only stores the non-zero span of every (triangular) filter,
+     * so projecting a power spectrum onto it skips the zero taps.
+     */
+    typedef struct {
+        uint16_t num_filters;
+        int coefficients;
+        uint32_t sampling_freq;
+        uint32_t low_freq;
+        uint32_t high_freq;
+        uint32_t last_used;
+        mel_filterbank_row_t *rows;
+        mel_filterbank_weight_t *weights;
+        size_t mem_length;
+    } mel_filterbank_t;
+
+    /**
+     * Compute a sparse Mel-filterbank (see filterbanks() for the parameters)
+     * @param fb Empty filterbank, free with free_mel_filterbank
+     * @returns EIDSP_OK if OK
+     */
+    static int create_mel_filterbank(
+        mel_filterbank_t *fb,
+        uint16_t num_filter, int coefficients, uint32_t sampling_freq,
+        uint32_t low_freq, uint32_t high_freq)
+    {
+        // build the dense filterbank once, then only keep the non-zero taps
+#if EIDSP_QUANTIZE_FILTERBANK
+        EI_DSP_QUANTIZED_MATRIX(dense, num_filter, coefficients, &numpy::dequantize_zero_one);
+#else
+        EI_DSP_MATRIX(dense, num_filter, coefficients);
+#endif
+        if (!dense.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        int ret = filterbanks(&dense, num_filter, coefficients, sampling_freq, low_freq, high_freq, false);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        size_t weights_count = 0;
+        for (size_t i = 0; i < num_filter; i++) {
+            int first, last;
+            get_non_zero_span(&dense.buffer[i * coefficients], coefficients, &first, &last);
+            weights_count += last - first + 1;
+        }
+
+        const size_t rows_mem_length = num_filter * sizeof(mel_filterbank_row_t);
+        fb->mem_length = rows_mem_length + weights_count * sizeof(mel_filterbank_weight_t);
+        fb->rows = (mel_filterbank_row_t*)ei_dsp_malloc(fb->mem_length);
+        if (!fb->rows) {
+            fb->mem_length = 0;
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        fb->weights = (mel_filterbank_weight_t*)((uint8_t*)fb->rows + rows_mem_length);
+
+        uint32_t offset = 0;
+        for (size_t i = 0; i < num_filter; i++) {
+            int first, last;
+            get_non_zero_span(&dense.buffer[i * coefficients], coefficients, &first, &last);
+
+            fb->rows[i].start = first;
+            fb->rows[i].length = last - first + 1;
+            fb->rows[i].offset = offset;
+            for (int k = first; k <= last; k++) {
+                fb->weights[offset++] = dense.buffer[i * coefficients + k];
+            }
+        }
+
+        fb->num_filters = num_filter;
+        fb->coefficients = coefficients;
+        fb->sampling_freq = sampling_freq;
+        fb->low_freq = low_freq;
+        fb->high_freq = high_freq;
+
+        return EIDSP_OK;
+    }
+
+    static void free_mel_filterbank(mel_filterbank_t *fb) {
+        if (fb->rows) {
+            ei_dsp_free(fb->rows, fb->mem_length);
+        }
+        memset(fb, 0, sizeof(mel_filterbank_t));
+    }
+
+    /**
+     * Project one power spectrum frame onto the filterbank
+     * @param fb Filterbank
+     * @param power_spectrum Power spectrum (fb->coefficients values)
+     * @param out Output, one value per filter
+     */
+    static void apply_mel_filterbank(const mel_filterbank_t *fb, const float *power_spectrum, float *out) {
+        for (size_t i = 0; i < fb->num_filters; i++) {
+            const float *ps = power_spectrum + fb->rows[i].start;
+            const mel_filterbank_weight_t *w = fb->weights + fb->rows[i].offset;
+            const size_t length = fb->rows[i].length;
+
+            float tmp = 0.0f;
+            for (size_t k = 0; k < length; k++) {
+#if EIDSP_QUANTIZE_FILTERBANK
+                tmp += ps[k] * quantized_values_one_zero[w[k]];
+#else
+                tmp += ps[k] * w[k];
+#endif
+            }
+            out[i] = tmp;
+        }
+    }
+
+    /**
+     * Free all cached mel filterbanks (see EIDSP_MEL_FILTERBANK_CACHE_SIZE).
+     * They will be created again on the next mfe call.
+     */
+    static void clear_mel_filterbank_cache() {
+#if EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+        free_mel_filterbank_cache(get_mel_filterbank_cache());
+#endif
+    }
+
+    /**
+     * Get the sparse mel filterbank for a config, from the cache if enabled
+     * @param fb Out: the filterbank
+     * @param uncached Filterbank to build into when the cache is disabled.
+     *                 Always pass it to free_mel_filterbank when done (no-op if unused).
+     * @returns EIDSP_OK if OK
+     */
+    static int get_mel_filterbank(
+        const mel_filterbank_t **fb, mel_filterbank_t *uncached,
+        uint16_t num_filter, int coefficients, uint32_t sampling_freq,
+        uint32_t low_freq, uint32_t high_freq)
+    {
+#if EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+        (void)uncached;
+
+        mel_filterbank_cache_t *cache = get_mel_filterbank_cache();
+        cache->tick++;
+
+        mel_filterbank_t *lru = &cache->filterbanks[0];
+        for (size_t ix = 0; ix < EIDSP_MEL_FILTERBANK_CACHE_SIZE; ix++) {
+            mel_filterbank_t *entry = &cache->filterbanks[ix];
+            if (entry->rows &&
+                entry->num_filters == num_filter && entry->coefficients == coefficients &&
+                entry->sampling_freq == sampling_freq &&
+                entry->low_freq == low_freq && entry->high_freq == high_freq) {
+
+                entry->last_used = cache->tick;
+                *fb = entry;
+                return EIDSP_OK;
+            }
+            if (entry->last_used < lru->last_used) {
+                lru = entry;
+            }
+        }
+
+        free_mel_filterbank(lru);
+        int ret = create_mel_filterbank(lru, num_filter, coefficients, sampling_freq, low_freq, high_freq);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+        lru->last_used = cache->tick;
+        *fb = lru;
+        return EIDSP_OK;
+#else
+        int ret = create_mel_filterbank(uncached, num_filter, coefficients, sampling_freq, low_freq, high_freq);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+        *fb = uncached;
+        return EIDSP_OK;
+#endif
+    }
+
     /**
      * Compute Mel-filterbank energy features from an audio signal.
      * @param out_features Use `calculate_mfe_buffer_size` to allocate the right matrix.
@@ -234,81 +419,19 @@ public:
 
         uint16_t coefficients = fft_length / 2 + 1;
 
-        // calculate the filterbanks first... preferably I would want to do the matrix multiplications
-        // whenever they happen, but OK...
-#if EIDSP_QUANTIZE_FILTERBANK
-        EI_DSP_QUANTIZED_MATRIX(filterbanks, num_filters, coefficients, &numpy::dequantize_zero_one);
-#else
-        EI_DSP_MATRIX(filterbanks, num_filters, coefficients);
-#endif
-        if (!filterbanks.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-
-        ret = feature::filterbanks(
-            &filterbanks, num_filters, coefficients, sampling_frequency, low_frequency, high_frequency, true);
+        // the filterbank only depends on the config, so it's cached between calls
+        mel_filterbank_t uncached_filterbank = { };
+        const mel_filterbank_t *filterbank = nullptr;
+        ret = get_mel_filterbank(&filterbank, &uncached_filterbank,
+            num_filters, coefficients, sampling_frequency, low_frequency, high_frequency);
         if (ret != 0) {
             EIDSP_ERR(ret);
         }
-        for (size_t ix = 0; ix < stack_frame_info.frame_ixs.size(); ix++) {
-            size_t power_spectrum_frame_size = (fft_length / 2 + 1);
-
-            EI_DSP_MATRIX(power_spectrum_frame, 1, power_spectrum_frame_size);
-            if (!power_spectrum_frame.buffer) {
-                EIDSP_ERR(EIDSP_OUT_OF_MEM);
-            }
-
-            // get signal data from the audio file
-            EI_DSP_MATRIX(signal_frame, 1, stack_frame_info.frame_length);
 
-            // don't read outside of the audio buffer... we'll automatically zero pad then
-            size_t signal_offset = stack_frame_info.frame_ixs.at(ix);
-            size_t signal_length = stack_frame_info.frame_length;
-            if (signal_offset + signal_length > stack_frame_info.signal->total_length) {
-                signal_length = signal_length -
-                    (stack_frame_info.signal->total_length - (signal_offset + signal_length));
-            }
-
-            ret = stack_frame_info.signal->get_data(
-                signal_offset,
-                signal_length,
-                signal_frame.buffer
-            );
-            if (ret != 0) {
-                EIDSP_ERR(ret);
-            }
-
-            ret = numpy::power_spectrum(
-                signal_frame.buffer,
-                stack_frame_info.frame_length,
-                power_spectrum_frame.buffer,
-                power_spectrum_frame_size,
-                fft_length
-            );
-
-            if (ret != 0) {
-                EIDSP_ERR(ret);
-            }
-
-            float energy = numpy::sum(power_spectrum_frame.buffer, power_spectrum_frame_size);
-            if (energy == 0) {
-                energy = 1e-10;
-            }
-
-            out_energies->buffer[ix] = energy;
-
-            // calculate the out_features directly here
-            ret = numpy::dot_by_row(
-                ix,
-                power_spectrum_frame.buffer,
-                power_spectrum_frame_size,
-                &filterbanks,
-                out_features
-            );
-
-            if (ret != 0) {
-                EIDSP_ERR(ret);
-            }
+        ret = mfe_frames(out_features, out_energies, &stack_frame_info, filterbank, fft_length);
+        free_mel_filterbank(&uncached_filterbank);
+        if (ret != 0) {
+            EIDSP_ERR(ret);
         }
 
         numpy::zero_handling(out_features);
@@ -366,23 +489,17 @@ public:
             *(out_features->buffer + i) = 0;
         }
 
-        for (size_t ix = 0; ix < stack_frame_info.frame_ixs.size(); ix++) {
-            // get signal data from the audio file
-            EI_DSP_MATRIX(signal_frame, 1, stack_frame_info.frame_length);
-
-            // don't read outside of the audio buffer... we'll automatically zero pad then
-            size_t signal_offset = stack_frame_info.frame_ixs.at(ix);
-            size_t signal_length = stack_frame_info.frame_length;
-            if (signal_offset + signal_length > stack_frame_info.signal->total_length) {
-                signal_length = signal_length -
-                    (stack_frame_info.signal->total_length - (signal_offset + signal_length));
-            }
+        // one workspace for all frames: signal frame and FFT scratch
+        EI_DSP_MATRIX(workspace, 1,
+            stack_frame_info.frame_length + numpy::rfft_scratch_size(fft_length));
+        if (!workspace.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        matrix_t signal_frame(1, stack_frame_info.frame_length, workspace.buffer);
+        float *fft_scratch = workspace.buffer + stack_frame_info.frame_length;
 
-            ret = stack_frame_info.signal->get_data(
-                signal_offset,
-                signal_length,
-                signal_frame.buffer
-            );
+        for (size_t ix = 0; ix < stack_frame_info.frame_ixs.size(); ix++) {
+            ret = read_frame(&stack_frame_info, ix, signal_frame.buffer);
             if (ret != 0) {
                 EIDSP_ERR(ret);
             }
@@ -411,7 +528,8 @@ public:
                 stack_frame_info.frame_length,
                 out_features->buffer + (ix * coefficients),
                 coefficients,
-                fft_length
+                fft_length,
+                fft_scratch
             );
 
             if (ret != 0) {
@@ -577,6 +695,142 @@ public:
         size_matrix.cols = (uint32_t)cols;
         return size_matrix;
     }
+
+private:
+#if EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+    typedef struct {
+        mel_filterbank_t filterbanks[EIDSP_MEL_FILTERBANK_CACHE_SIZE];
+        uint32_t tick;
+    } mel_filterbank_cache_t;
+
+    static mel_filterbank_cache_t *get_mel_filterbank_cache() {
+#if EIDSP_CACHE_THREAD_LOCAL == 1
+        // every thread has its own cache, the filterbanks are freed when the thread exits
+        struct thread_cache_t {
+            mel_filterbank_cache_t cache;
+            ~thread_cache_t() { free_mel_filterbank_cache(&cache); }
+        };
+        static thread_local thread_cache_t thread_cache;
+        return &thread_cache.cache;
+#else
+        static mel_filterbank_cache_t cache = { };
+        return &cache;
+#endif
+    }
+
+    static void free_mel_filterbank_cache(mel_filterbank_cache_t *cache) {
+        for (size_t ix = 0; ix < EIDSP_MEL_FILTERBANK_CACHE_SIZE; ix++) {
+            free_mel_filterbank(&cache->filterbanks[ix]);
+        }
+        cache->tick = 0;
+    }
+#endif // EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+
+    /**
+     * Power spectrum, energy and filterbank projection for every frame (see mfe)
+     */
+    static int mfe_frames(matrix_t *out_features, matrix_t *out_energies,
+        stack_frames_info_t *stack_frame_info, const mel_filterbank_t *filterbank,
+        uint16_t fft_length)
+    {
+        int ret;
+
+        const size_t power_spectrum_frame_size = (fft_length / 2 + 1);
+        const size_t frame_length = stack_frame_info->frame_length;
+
+        // one workspace for all frames: power spectrum, signal frame and FFT scratch
+        EI_DSP_MATRIX(workspace, 1,
+            power_spectrum_frame_size + frame_length + numpy::rfft_scratch_size(fft_length));
+        if (!workspace.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        float *power_spectrum_frame = workspace.buffer;
+        float *signal_frame = power_spectrum_frame + power_spectrum_frame_size;
+        float *fft_scratch = signal_frame + frame_length;
+
+        for (size_t ix = 0; ix < stack_frame_info->frame_ixs.size(); ix++) {
+            ret = read_frame(stack_frame_info, ix, signal_frame);
+            if (ret != 0) {
+                EIDSP_ERR(ret);
+            }
+
+            ret = numpy::power_spectrum(
+                signal_frame,
+                frame_length,
+                power_spectrum_frame,
+                power_spectrum_frame_size,
+                fft_length,
+                fft_scratch
+            );
+
+            if (ret != 0) {
+                EIDSP_ERR(ret);
+            }
+
+            float energy = numpy::sum(power_spectrum_frame, power_spectrum_frame_size);
+            if (energy == 0) {
+                energy = 1e-10;
+            }
+
+            out_energies->buffer[ix] = energy;
+
+            // calculate the out_features directly here
+            apply_mel_filterbank(filterbank, power_spectrum_frame,
+                out_features->buffer + (ix * out_features->cols));
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Read frame ix of a stacked signal, zero padded if it runs past the end of the signal
+     * @param signal_frame Out buffer, stack_frame_info->frame_length values
+     */
+    static int read_frame(stack_frames_info_t *stack_frame_info, size_t ix, float *signal_frame) {
+        // don't read outside of the audio buffer... we'll automatically zero pad then
+        size_t signal_offset = stack_frame_info->frame_ixs.at(ix);
+        size_t frame_length = (size_t)stack_frame_info->frame_length;
+        size_t signal_length = frame_length;
+        if (signal_offset + signal_length > stack_frame_info->signal->total_length) {
+            signal_length = stack_frame_info->signal->total_length - signal_offset;
+        }
+
+        // the frame buffer is reused between frames, so pad explicitly
+        if (signal_length < frame_length) {
+            memset(signal_frame + signal_length, 0,
+                (frame_length - signal_length) * sizeof(float));
+        }
+
+        return stack_frame_info->signal->get_data(
+            signal_offset,
+            signal_length,
+            signal_frame
+        );
+    }
+
+    /**
+     * First and last non-zero value in a filterbank row (first = last = 0 if all zero)
+     */
+    template<typename T>
+    static void get_non_zero_span(const T *row, int length, int *first, int *last) {
+        *first = 0;
+        *last = 0;
+        for (int ix = 0; ix < length; ix++) {
+            if (row[ix] != 0) {
+                *first = ix;
+                break;
+            }
+        }
+        for (int ix = length - 1; ix >= *first; ix--) {
+            if (row[ix] != 0) {
+                *last = ix;
+                break;
+            }
+        }
+        if (*last < *first) {
+            *last = *first;
+        }
+    }
 };
 
 } // namespace speechpy
@@ -379,10 +379,25 @@ namespace processing {
         return numframes;
     }
 
+    /**
+     * Row of the original matrix that row ix of a matrix padded with
+     * numpy::pad_1d_symmetric maps to (ix is relative to the first unpadded row,
+     * so negative in the padding before)
+     */
+    static inline size_t symmetric_pad_index(int32_t ix, int32_t rows) {
+        int32_t m = ix % (2 * rows);
+        if (m < 0) {
+            m += 2 * rows;
+        }
+        return m < rows ? m : (2 * rows) - 1 - m;
+    }
+
     /**
      * This function performs local cepstral mean and
      * variance normalization on a sliding window. The code assumes that
      * there is one observation per row.
+     * The window sums are kept running (rather than recalculated for every row),
+     * so this is O(rows * cols) regardless of the window size.
      * @param features_matrix input feature matrix, will be modified in place
      * @param win_size The size of sliding window for local normalization.
      *   Default=301 which is around 3s if 100 Hz rate is
@@ -399,78 +414,88 @@ namespace processing {
             return EIDSP_OK;
         }
 
-        uint16_t pad_size = (win_size - 1) / 2;
+        if (features_matrix->rows == 0) {
+            EIDSP_ERR(EIDSP_INPUT_MATRIX_EMPTY);
+        }
+
+        const int32_t rows = features_matrix->rows;
+        const size_t cols = features_matrix->cols;
+        const int32_t pad_size = (win_size - 1) / 2;
 
         int ret;
-        float *features_buffer_ptr;
 
-        // mean & variance normalization
-        EI_DSP_MATRIX(vec_pad, features_matrix->rows + (pad_size * 2), features_matrix->cols);
-        if (!vec_pad.buffer) {
+        // the rows are normalized in place, so the windows read from a copy
+        EI_DSP_MATRIX(original, features_matrix->rows, features_matrix->cols);
+        if (!original.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
+        memcpy(original.buffer, features_matrix->buffer, rows * cols * sizeof(float));
 
-        ret = numpy::pad_1d_symmetric(features_matrix, &vec_pad, pad_size, pad_size);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
-        }
-
-        EI_DSP_MATRIX(mean_matrix, vec_pad.cols, 1);
-        if (!mean_matrix.buffer) {
+        // running sum (and sum of squares) of the window, per column
+        const size_t sums_mem_size = cols * 2 * sizeof(double);
+        double *sums = (double*)ei_dsp_calloc(sums_mem_size, 1);
+        if (!sums) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
+        double *sums_sq = sums + cols;
 
-        EI_DSP_MATRIX(window_variance, vec_pad.cols, 1);
-        if (!window_variance.buffer) {
-            return EIDSP_OUT_OF_MEM;
-        }
-
-        for (size_t ix = 0; ix < features_matrix->rows; ix++) {
-            // create a slice on the vec_pad
-            EI_DSP_MATRIX_B(window, win_size, vec_pad.cols, vec_pad.buffer + (ix * vec_pad.cols));
-            if (!window.buffer) {
-                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        // mean normalization, the window for row ix covers padded rows ix - pad_size .. ix - pad_size + win_size - 1
+        for (int32_t w = -pad_size; w < win_size - pad_size; w++) {
+            float *row = original.buffer + (symmetric_pad_index(w, rows) * cols);
+            for (size_t col = 0; col < cols; col++) {
+                sums[col] += row[col];
             }
+        }
 
-            ret = numpy::mean_axis0(&window, &mean_matrix);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(ret);
+        for (int32_t ix = 0; ix < rows; ix++) {
+            float *features = features_matrix->buffer + (ix * cols);
+            for (size_t col = 0; col < cols; col++) {
+                features[col] = original.buffer[(ix * cols) + col] - static_cast<float>(sums[col] / win_size);
             }
 
-            // subtract the mean for the features
-            for (size_t fm_col = 0; fm_col < features_matrix->cols; fm_col++) {
-                features_matrix->buffer[(ix * features_matrix->cols) + fm_col] =
-                    features_matrix->buffer[(ix * features_matrix->cols) + fm_col] - mean_matrix.buffer[fm_col];
+            // slide the window one row
+            float *row_out = original.buffer + (symmetric_pad_index(ix - pad_size, rows) * cols);
+            float *row_in = original.buffer + (symmetric_pad_index(ix - pad_size + win_size, rows) * cols);
+            for (size_t col = 0; col < cols; col++) {
+                sums[col] += static_cast<double>(row_in[col]) - row_out[col];
             }
         }
 
-        ret = numpy::pad_1d_symmetric(features_matrix, &vec_pad, pad_size, pad_size);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
-        }
+        // variance normalization, over windows of the mean normalized features
+        if (variance_normalization == true) {
+            memcpy(original.buffer, features_matrix->buffer, rows * cols * sizeof(float));
+            memset(sums, 0, sums_mem_size);
 
-        for (size_t ix = 0; ix < features_matrix->rows; ix++) {
-            // create a slice on the vec_pad
-            EI_DSP_MATRIX_B(window, win_size, vec_pad.cols, vec_pad.buffer + (ix * vec_pad.cols));
-            if (!window.buffer) {
-                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            for (int32_t w = -pad_size; w < win_size - pad_size; w++) {
+                float *row = original.buffer + (symmetric_pad_index(w, rows) * cols);
+                for (size_t col = 0; col < cols; col++) {
+                    sums[col] += row[col];
+                    sums_sq[col] += static_cast<double>(row[col]) * row[col];
+                }
             }
 
-            if (variance_normalization == true) {
-                ret = numpy::std_axis0(&window, &window_variance);
-                if (ret != EIDSP_OK) {
-                    EIDSP_ERR(ret);
+            for (int32_t ix = 0; ix < rows; ix++) {
+                float *features = features_matrix->buffer + (ix * cols);
+                for (size_t col = 0; col < cols; col++) {
+                    double mean = sums[col] / win_size;
+                    double variance = (sums_sq[col] / win_size) - (mean * mean);
+                    float std = variance > 0.0 ? static_cast<float>(sqrt(variance)) : 0.0f;
+
+                    features[col] = features[col] / (std + 1e-10);
                 }
 
-                features_buffer_ptr = &features_matrix->buffer[ix * vec_pad.cols];
-                for (size_t col = 0; col < vec_pad.cols; col++) {
-                    *(features_buffer_ptr) = (*(features_buffer_ptr)) /
-                                             (window_variance.buffer[col] + 1e-10);
-                    features_buffer_ptr++;
+                float *row_out = original.buffer + (symmetric_pad_index(ix - pad_size, rows) * cols);
+                float *row_in = original.buffer + (symmetric_pad_index(ix - pad_size + win_size, rows) * cols);
+                for (size_t col = 0; col < cols; col++) {
+                    sums[col] += static_cast<double>(row_in[col]) - row_out[col];
+                    sums_sq[col] += (static_cast<double>(row_in[col]) * row_in[col]) -
+                                    (static_cast<double>(row_out[col]) * row_out[col]);
                 }
             }
         }
 
+        ei_dsp_free(sums, sums_mem_size);
+
         if (scale) {
             ret = numpy::normalize(features_matrix);
             if (ret != EIDSP_OK) {
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "ei_classifier_porting.h"
+
+// Defaults shared by all ports, a port (or the application) overrides these
+// by defining the same function.
+
+#if defined(__GNUC__) && !defined(_WIN32)
+
+/**
+ * Ports without a finer clock only need to implement ei_read_timer_us()
+ */
+__attribute__((weak)) uint64_t ei_read_timer_ns() {
+    return ei_read_timer_us() * 1000;
+}
+
+#endif // defined(__GNUC__) && !defined(_WIN32)
@@ -71,6 +71,13 @@ uint64_t ei_read_timer_ms();
  */
 uint64_t ei_read_timer_us();
 
+/**
+ * Read the nanosecond timer. Only used to measure intervals, so it should be
+ * monotonic. Optional, the default (porting/ei_classifier_porting.cpp) returns
+ * the microsecond timer * 1000
+ */
+uint64_t ei_read_timer_ns();
+
 /**
  * Set Serial baudrate
  */
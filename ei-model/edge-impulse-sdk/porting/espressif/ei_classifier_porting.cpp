@@ -47,6 +47,10 @@ uint64_t ei_read_timer_us() {
     return esp_timer_get_time();
 }
 
+uint64_t ei_read_timer_ns() {
+    return ei_read_timer_us() * 1000;
+}
+
 void ei_putchar(char c)
 {
     /* Send char to serial output */
@@ -53,6 +53,13 @@ uint64_t ei_read_timer_us() {
     return static_cast<uint64_t>(micros);
 }
 
+uint64_t ei_read_timer_ns() {
+    auto now = std::chrono::steady_clock::now();
+    auto duration = now.time_since_epoch();
+    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    return static_cast<uint64_t>(nanos);
+}
+
 void ei_printf(const char *format, ...) {
     va_list myargs;
     va_start(myargs, format);
@@ -39,24 +39,24 @@ __attribute__((weak)) EI_IMPULSE_ERROR ei_sleep(int32_t time_ms) {
 }
 
 uint64_t ei_read_timer_ms() {
-    return ei_read_timer_us() / 1000;
+    return ei_read_timer_ns() / 1000000;
 }
 
 uint64_t ei_read_timer_us() {
-    uint64_t us; // Milliseconds
-    uint64_t s;  // Seconds
-    struct timespec spec;
+    return ei_read_timer_ns() / 1000;
+}
 
-    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &spec);
+/**
+ * Wall-clock time since an arbitrary point in the past. This is a monotonic clock
+ * rather than the process CPU clock, so it still measures latency when several
+ * threads run inferences at the same time.
+ */
+uint64_t ei_read_timer_ns() {
+    struct timespec spec;
 
-    s  = spec.tv_sec;
-    us = round(spec.tv_nsec / 1.0e3); // Convert nanoseconds to micros
-    if (us > 999999) {
-        s++;
-        us = 0;
-    }
+    clock_gettime(CLOCK_MONOTONIC, &spec);
 
-    return (s * 1000000) + us;
+    return ((uint64_t)spec.tv_sec * 1000000000ULL) + (uint64_t)spec.tv_nsec;
 }
 
 __attribute__((weak)) void ei_printf(const char *format, ...) {
@@ -57,6 +57,10 @@ uint64_t ei_read_timer_us() {
     return timer_get_ms()*1000;
 }
 
+uint64_t ei_read_timer_ns() {
+    return ei_read_timer_us() * 1000;
+}
+
 __attribute__((weak)) void ei_printf(const char *format, ...) {
 
     char buffer[256] = {0};
@@ -62,6 +62,17 @@ uint64_t ei_read_timer_us() {
     return time_us;
 }
 
+uint64_t ei_read_timer_ns() {
+
+    uint64_t time_ns;
+    uint32_t seconds, nano_seconds;
+
+    spresense_time_cb(&seconds, &nano_seconds);
+
+    time_ns = ((uint64_t)seconds * 1000000000) + nano_seconds;
+    return time_ns;
+}
+
 __attribute__((weak)) void ei_printf(const char *format, ...) {
 
     va_list myargs;
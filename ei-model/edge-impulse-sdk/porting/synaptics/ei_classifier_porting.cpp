@@ -55,6 +55,10 @@ uint64_t ei_read_timer_us() {
     return get_time_ms() * 1000;
 }
 
+uint64_t ei_read_timer_ns() {
+    return ei_read_timer_us() * 1000;
+}
+
 __attribute__((weak)) void ei_printf(const char *format, ...) {
     va_list args;
     va_start(args, format);
@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_FULLY_CONNECTED_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_FULLY_CONNECTED_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace tflite {
+namespace optimized_integer_ops {
+
+// Number of output channels that are calculated together, sharing every load
+// of the input.
+constexpr int kFullyConnectedRows = 4;
+
+// The offsets are added after widening to int16, so (filter + filter_offset) *
+// (input + input_offset) is at most 255 * 255 and the int16 -> int32
+// multiply-adds are exact: same sums as the reference kernel.
+#if defined(__AVX2__)
+inline __m256i FullyConnectedDotRow(__m256i acc, const int8_t* row, __m256i x,
+                                    __m256i filter_offset) {
+  const __m256i f = _mm256_add_epi16(
+      _mm256_cvtepi8_epi16(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(row))),
+      filter_offset);
+  return _mm256_add_epi32(acc, _mm256_madd_epi16(f, x));
+}
+
+inline int32_t FullyConnectedHorizontalSum(__m256i acc) {
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc),
+                              _mm256_extracti128_si256(acc, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+  return _mm_cvtsi128_si32(sum);
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+// Sign extends the low / high 8 bytes to int16 (SSE2 only, SSE4.1's
+// _mm_cvtepi8_epi16 is not faster here).
+inline __m128i FullyConnectedWidenLow(__m128i v) {
+  return _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+}
+
+inline __m128i FullyConnectedWidenHigh(__m128i v) {
+  return _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+}
+
+inline __m128i FullyConnectedDotRow(__m128i acc, const int8_t* row,
+                                    __m128i x_low, __m128i x_high,
+                                    __m128i filter_offset) {
+  const __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+  const __m128i f_low =
+      _mm_add_epi16(FullyConnectedWidenLow(f), filter_offset);
+  const __m128i f_high =
+      _mm_add_epi16(FullyConnectedWidenHigh(f), filter_offset);
+  acc = _mm_add_epi32(acc, _mm_madd_epi16(f_low, x_low));
+  return _mm_add_epi32(acc, _mm_madd_epi16(f_high, x_high));
+}
+
+inline int32_t FullyConnectedHorizontalSum(__m128i acc) {
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+  return _mm_cvtsi128_si32(acc);
+}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+inline int32x4_t FullyConnectedDotRow(int32x4_t acc, const int8_t* row,
+                                      int16x8_t x_low, int16x8_t x_high,
+                                      int16x8_t filter_offset) {
+  const int8x16_t f = vld1q_s8(row);
+  const int16x8_t f_low = vaddq_s16(vmovl_s8(vget_low_s8(f)), filter_offset);
+  const int16x8_t f_high =
+      vaddq_s16(vmovl_s8(vget_high_s8(f)), filter_offset);
+  acc = vmlal_s16(acc, vget_low_s16(f_low), vget_low_s16(x_low));
+  acc = vmlal_s16(acc, vget_high_s16(f_low), vget_high_s16(x_low));
+  acc = vmlal_s16(acc, vget_low_s16(f_high), vget_low_s16(x_high));
+  return vmlal_s16(acc, vget_high_s16(f_high), vget_high_s16(x_high));
+}
+
+inline int32_t FullyConnectedHorizontalSum(int32x4_t acc) {
+#if defined(__aarch64__)
+  return vaddvq_s32(acc);
+#else
+  const int32x2_t sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+  return vget_lane_s32(vpadd_s32(sum, sum), 0);
+#endif
+}
+#endif
+
+// Dot products of (input + input_offset) with kFullyConnectedRows rows of
+// (filter + filter_offset), 16 values at a time in SIMD lanes (AVX2, SSE2 or
+// NEON), the rest in plain C.
+inline void FullyConnectedDotProducts(const int8_t* input,
+                                      const int8_t* const* filter_rows,
+                                      int depth, int32_t input_offset,
+                                      int32_t filter_offset, int32_t* dot) {
+  int d = 0;
+#if defined(__AVX2__)
+  const __m256i input_offset_v =
+      _mm256_set1_epi16(static_cast<int16_t>(input_offset));
+  const __m256i filter_offset_v =
+      _mm256_set1_epi16(static_cast<int16_t>(filter_offset));
+  __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+  __m256i acc2 = _mm256_setzero_si256(), acc3 = _mm256_setzero_si256();
+  for (; d + 16 <= depth; d += 16) {
+    const __m256i x = _mm256_add_epi16(
+        _mm256_cvtepi8_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + d))),
+        input_offset_v);
+    acc0 = FullyConnectedDotRow(acc0, filter_rows[0] + d, x, filter_offset_v);
+    acc1 = FullyConnectedDotRow(acc1, filter_rows[1] + d, x, filter_offset_v);
+    acc2 = FullyConnectedDotRow(acc2, filter_rows[2] + d, x, filter_offset_v);
+    acc3 = FullyConnectedDotRow(acc3, filter_rows[3] + d, x, filter_offset_v);
+  }
+  dot[0] = FullyConnectedHorizontalSum(acc0);
+  dot[1] = FullyConnectedHorizontalSum(acc1);
+  dot[2] = FullyConnectedHorizontalSum(acc2);
+  dot[3] = FullyConnectedHorizontalSum(acc3);
+#elif defined(__SSE2__) || defined(_M_X64)
+  const __m128i input_offset_v =
+      _mm_set1_epi16(static_cast<int16_t>(input_offset));
+  const __m128i filter_offset_v =
+      _mm_set1_epi16(static_cast<int16_t>(filter_offset));
+  __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+  __m128i acc2 = _mm_setzero_si128(), acc3 = _mm_setzero_si128();
+  for (; d + 16 <= depth; d += 16) {
+    const __m128i x =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + d));
+    const __m128i x_low =
+        _mm_add_epi16(FullyConnectedWidenLow(x), input_offset_v);
+    const __m128i x_high =
+        _mm_add_epi16(FullyConnectedWidenHigh(x), input_offset_v);
+    acc0 = FullyConnectedDotRow(acc0, filter_rows[0] + d, x_low, x_high,
+                                filter_offset_v);
+    acc1 = FullyConnectedDotRow(acc1, filter_rows[1] + d, x_low, x_high,
+                                filter_offset_v);
+    acc2 = FullyConnectedDotRow(acc2, filter_rows[2] + d, x_low, x_high,
+                                filter_offset_v);
+    acc3 = FullyConnectedDotRow(acc3, filter_rows[3] + d, x_low, x_high,
+                                filter_offset_v);
+  }
+  dot[0] = FullyConnectedHorizontalSum(acc0);
+  dot[1] = FullyConnectedHorizontalSum(acc1);
+  dot[2] = FullyConnectedHorizontalSum(acc2);
+  dot[3] = FullyConnectedHorizontalSum(acc3);
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  const int16x8_t input_offset_v =
+      vdupq_n_s16(static_cast<int16_t>(input_offset));
+  const int16x8_t filter_offset_v =
+      vdupq_n_s16(static_cast<int16_t>(filter_offset));
+  int32x4_t acc0 = vdupq_n_s32(0), acc1 = vdupq_n_s32(0);
+  int32x4_t acc2 = vdupq_n_s32(0), acc3 = vdupq_n_s32(0);
+  for (; d + 16 <= depth; d += 16) {
+    const int8x16_t x = vld1q_s8(input + d);
+    const int16x8_t x_low = vaddq_s16(vmovl_s8(vget_low_s8(x)), input_offset_v);
+    const int16x8_t x_high =
+        vaddq_s16(vmovl_s8(vget_high_s8(x)), input_offset_v);
+    acc0 = FullyConnectedDotRow(acc0, filter_rows[0] + d, x_low, x_high,
+                                filter_offset_v);
+    acc1 = FullyConnectedDotRow(acc1, filter_rows[1] + d, x_low, x_high,
+                                filter_offset_v);
+    acc2 = FullyConnectedDotRow(acc2, filter_rows[2] + d, x_low, x_high,
+                                filter_offset_v);
+    acc3 = FullyConnectedDotRow(acc3, filter_rows[3] + d, x_low, x_high,
+                                filter_offset_v);
+  }
+  dot[0] = FullyConnectedHorizontalSum(acc0);
+  dot[1] = FullyConnectedHorizontalSum(acc1);
+  dot[2] = FullyConnectedHorizontalSum(acc2);
+  dot[3] = FullyConnectedHorizontalSum(acc3);
+#else
+  for (int r = 0; r < kFullyConnectedRows; ++r) {
+    dot[r] = 0;
+  }
+#endif
+  for (; d < depth; ++d) {
+    const int32_t input_val = input[d] + input_offset;
+    for (int r = 0; r < kFullyConnectedRows; ++r) {
+      dot[r] += (filter_rows[r][d] + filter_offset) * input_val;
+    }
+  }
+}
+
+// output_multiplier / output_shift hold one value per output channel when
+// multiplier_stride is 1, or one for all channels when it's 0.
+inline void FullyConnectedImpl(
+    const FullyConnectedParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, int multiplier_stride,
+    const RuntimeShape& input_shape, const int8_t* input_data,
+    const RuntimeShape& filter_shape, const int8_t* filter_data,
+    const RuntimeShape& bias_shape, const int32_t* bias_data,
+    const RuntimeShape& output_shape, int8_t* output_data) {
+  const int32_t input_offset = params.input_offset;
+  const int32_t filter_offset = params.weights_offset;
+  const int32_t output_offset = params.output_offset;
+  const int32_t output_activation_min = params.quantized_activation_min;
+  const int32_t output_activation_max = params.quantized_activation_max;
+  TFLITE_DCHECK_GE(filter_shape.DimensionsCount(), 2);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 2);
+
+  TFLITE_DCHECK_LE(output_activation_min, output_activation_max);
+  const int filter_dim_count = filter_shape.DimensionsCount();
+  const int batches = output_shape.Dims(0);
+  const int output_depth = output_shape.Dims(1);
+  TFLITE_DCHECK_LE(output_depth, filter_shape.Dims(filter_dim_count - 2));
+  const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
+
+  for (int b = 0; b < batches; ++b) {
+    const int8_t* input = input_data + b * accum_depth;
+    for (int out_c = 0; out_c < output_depth; out_c += kFullyConnectedRows) {
+      const int rows = std::min(kFullyConnectedRows, output_depth - out_c);
+      // a short last block repeats its first row, so the kernel always has
+      // full blocks
+      const int8_t* filter_rows[kFullyConnectedRows];
+      for (int r = 0; r < kFullyConnectedRows; ++r) {
+        filter_rows[r] = filter_data + (out_c + (r < rows ? r : 0)) * accum_depth;
+      }
+      int32_t dot[kFullyConnectedRows];
+      FullyConnectedDotProducts(input, filter_rows, accum_depth, input_offset,
+                                filter_offset, dot);
+
+      for (int r = 0; r < rows; ++r) {
+        const int channel = out_c + r;
+        int32_t acc = dot[r];
+        if (bias_data) {
+          acc += bias_data[channel];
+        }
+        acc = MultiplyByQuantizedMultiplier(
+            acc, output_multiplier[channel * multiplier_stride],
+            output_shift[channel * multiplier_stride]);
+        acc += output_offset;
+        acc = std::max(acc, output_activation_min);
+        acc = std::min(acc, output_activation_max);
+        output_data[channel + output_depth * b] = static_cast<int8_t>(acc);
+      }
+    }
+  }
+}
+
+// Same results as reference_integer_ops::FullyConnected (int8).
+inline void FullyConnected(
+    const FullyConnectedParams& params, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const RuntimeShape& bias_shape,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data) {
+  const int32_t output_multiplier = params.output_multiplier;
+  const int32_t output_shift = params.output_shift;
+  FullyConnectedImpl(params, &output_multiplier, &output_shift, 0, input_shape,
+                     input_data, filter_shape, filter_data, bias_shape,
+                     bias_data, output_shape, output_data);
+}
+
+// int8 fully connected with per-channel quantized weights: one multiplier and
+// shift per output channel (params.output_multiplier / output_shift are not
+// used).
+inline void FullyConnectedPerChannel(
+    const FullyConnectedParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const RuntimeShape& bias_shape,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data) {
+  FullyConnectedImpl(params, output_multiplier, output_shift, 1, input_shape,
+                     input_data, filter_shape, filter_data, bias_shape,
+                     bias_data, output_shape, output_data);
+}
+
+}  // namespace optimized_integer_ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_FULLY_CONNECTED_H_
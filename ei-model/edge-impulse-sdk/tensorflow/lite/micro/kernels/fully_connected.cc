@@ -79,6 +79,9 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_STATUS(CalculateOpDataFullyConnected(
       context, params->activation, input->type, input, filter, bias, output,
       &(data->reference_op_data)));
+  TF_LITE_ENSURE_MSG(
+      context, data->reference_op_data.per_channel_output_multiplier == nullptr,
+      "Per-channel quantized fully connected is not supported by this kernel.");
 
   if (input->type == kTfLiteInt8) {
     RuntimeShape filter_shape = GetTensorShape(filter);
@@ -1203,8 +1206,13 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_MSG(context, input->type == filter->type,
                      "Hybrid models are not supported on TFLite Micro.");
 
-  return CalculateOpDataFullyConnected(context, params->activation, input->type,
-                                       input, filter, bias, output, data);
+  TF_LITE_ENSURE_STATUS(CalculateOpDataFullyConnected(
+      context, params->activation, input->type, input, filter, bias, output,
+      data));
+  TF_LITE_ENSURE_MSG(
+      context, data->per_channel_output_multiplier == nullptr,
+      "Per-channel quantized fully connected is not supported by this kernel.");
+  return kTfLiteOk;
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
@@ -1347,6 +1355,7 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/optimized/integer_ops/fully_connected.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/quantization_util.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/fully_connected.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
@@ -1437,7 +1446,25 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteError;
       #endif
 
+      if (data.per_channel_output_multiplier != nullptr) {
+        tflite::optimized_integer_ops::FullyConnectedPerChannel(
+            FullyConnectedParamsQuantized(data),
+            data.per_channel_output_multiplier, data.per_channel_output_shift,
+            tflite::micro::GetTensorShape(input),
+            tflite::micro::GetTensorData<int8_t>(input),
+            tflite::micro::GetTensorShape(filter),
+            tflite::micro::GetTensorData<int8_t>(filter),
+            tflite::micro::GetTensorShape(bias),
+            tflite::micro::GetTensorData<int32_t>(bias),
+            tflite::micro::GetTensorShape(output),
+            tflite::micro::GetTensorData<int8_t>(output));
+        break;
+      }
+#if EI_CLASSIFIER_TFLITE_ENABLE_SIMD_FULLY_CONNECTED == 1
+      tflite::optimized_integer_ops::FullyConnected(
+#else
       tflite::reference_integer_ops::FullyConnected(
+#endif
           FullyConnectedParamsQuantized(data),
           tflite::micro::GetTensorShape(input),
           tflite::micro::GetTensorData<int8_t>(input),
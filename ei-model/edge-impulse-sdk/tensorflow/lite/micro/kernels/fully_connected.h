@@ -38,6 +38,10 @@ struct OpDataFullyConnected {
   int32_t input_zero_point;
   int32_t filter_zero_point;
   int32_t output_zero_point;
+  // Per-channel output multipliers and shifts for int8 layers with per-channel
+  // quantized weights, nullptr otherwise.
+  int32_t* per_channel_output_multiplier;
+  int32_t* per_channel_output_shift;
 };
 
 extern const int kFullyConnectedInputTensor;
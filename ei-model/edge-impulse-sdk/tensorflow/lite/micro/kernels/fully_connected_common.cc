@@ -57,6 +57,42 @@ TfLiteStatus CalculateOpDataFullyConnected(
     TfLiteType data_type, const TfLiteTensor* input, const TfLiteTensor* filter,
     const TfLiteTensor* bias, TfLiteTensor* output,
     OpDataFullyConnected* data) {
+  data->per_channel_output_multiplier = nullptr;
+  data->per_channel_output_shift = nullptr;
+
+  const auto* affine_quantization =
+      filter->quantization.type == kTfLiteAffineQuantization
+          ? reinterpret_cast<const TfLiteAffineQuantization*>(
+                filter->quantization.params)
+          : nullptr;
+  if (data_type == kTfLiteInt8 && affine_quantization &&
+      affine_quantization->scale && affine_quantization->scale->size > 1) {
+    // Per-channel quantized weights, one scale per output channel
+    TF_LITE_ENSURE_EQ(context, affine_quantization->quantized_dimension, 0);
+    const int num_channels = filter->dims->data[0];
+    data->per_channel_output_multiplier =
+        static_cast<int32_t*>(context->AllocatePersistentBuffer(
+            context, num_channels * sizeof(int32_t)));
+    data->per_channel_output_shift =
+        static_cast<int32_t*>(context->AllocatePersistentBuffer(
+            context, num_channels * sizeof(int32_t)));
+    TF_LITE_ENSURE(context, data->per_channel_output_multiplier != nullptr &&
+                                data->per_channel_output_shift != nullptr);
+    TF_LITE_ENSURE_STATUS(PopulateConvolutionQuantizationParams(
+        context, input, filter, bias, output, activation,
+        &data->output_multiplier, &data->output_shift,
+        &data->output_activation_min, &data->output_activation_max,
+        data->per_channel_output_multiplier,
+        reinterpret_cast<int*>(data->per_channel_output_shift), num_channels));
+    data->output_multiplier = data->per_channel_output_multiplier[0];
+    data->output_shift = data->per_channel_output_shift[0];
+
+    data->input_zero_point = input->params.zero_point;
+    data->filter_zero_point = filter->params.zero_point;
+    data->output_zero_point = output->params.zero_point;
+    return kTfLiteOk;
+  }
+
   if (data_type != kTfLiteFloat32) {
     double real_multiplier = 0.0;
     TF_LITE_ENSURE_STATUS(GetQuantizedConvolutionMultipler(
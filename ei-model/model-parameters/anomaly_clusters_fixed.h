@@ -0,0 +1,183 @@
+/* Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EI_CLASSIFIER_ANOMALY_CLUSTERS_FIXED_H_
+#define _EI_CLASSIFIER_ANOMALY_CLUSTERS_FIXED_H_
+
+#include "edge-impulse-sdk/anomaly/anomaly.h"
+
+// Generated from anomaly_clusters.h by benchmark/gen_anomaly_clusters_fixed.cpp: the clusters
+// and scaler in fixed point, for EI_CLASSIFIER_ANOMALY_FIXED_POINT (see
+// ei_classifier_anom_clusters_fixed_t). Run make -C benchmark anomaly_clusters_fixed when the
+// model is exported again; the static_asserts catch other cluster or axis counts, and
+// benchmark/anomaly_fixed checks the scores against the float ones. Centroids and
+// max errors are value * 2^frac_bits, rounded and saturated to the range of the type; frac_bits
+// is the largest that fits twice the largest centroid.
+// EI_CLASSIFIER_ANOM_FIXED_TOLERANCE is (sqrt(axes) * (1 + e) + 1) / 2^frac_bits: every axis is
+// off by at most 1 + e (rounding the input and the centroid, e is the rounding of the integer
+// scaler), plus 1 for rounding the square root and max_error. Saturated features only lower
+// the score.
+
+#if EI_CLASSIFIER_ANOMALY_FIXED_POINT == 8
+
+// largest difference between the fixed-point and the float score
+#define EI_CLASSIFIER_ANOM_FIXED_TOLERANCE    0.171f
+
+const float ei_classifier_anom_fixed_input_limit[] = { 42.1798096, 23.2818279, 15.7133055 };
+const float ei_classifier_anom_fixed_input_mul[] = { 16777216, 33554432, 67108864 };
+const int32_t ei_classifier_anom_fixed_scaler_mul[] = { 1813778259, 1628689334, 1225530063 };
+const int64_t ei_classifier_anom_fixed_scaler_add[] = { -130616411822933718LL, -119424466249845873LL, -139402436730551552LL };
+const uint8_t ei_classifier_anom_fixed_scaler_shift[] = { 53, 53, 53 };
+
+const int8_t ei_classifier_anom_fixed_centroids[] = {
+    19, -1, 1,
+    17, -6, -4,
+    -11, 0, 29,
+    -14, -13, -15,
+    -10, 5, -4,
+    30, 0, 14,
+    21, -1, -7,
+    -12, -6, -13,
+    -8, -6, 37,
+    -11, -5, 25,
+    12, 45, 13,
+    -11, -2, -13,
+    25, 11, 8,
+    28, 4, 6,
+    -9, 10, 1,
+    -12, -8, 18,
+    -1, 62, -1,
+    15, 53, 19,
+    -5, 26, 1,
+    -7, 54, -3,
+    -12, -6, -9,
+    -9, 1, 22,
+    20, 5, -5,
+    -7, -3, 44,
+    14, -2, 13,
+    15, 0, -6,
+    30, 2, 23,
+    -2, 57, -6,
+    23, 10, 0,
+    20, -6, 10,
+    -2, 18, 12,
+    -4, 16, 42
+};
+const int32_t ei_classifier_anom_fixed_max_error[] = {
+    7, 6, 7, 1, 6, 7, 8, 4, 13, 6, 8, 4, 7, 7, 9, 7,
+    8, 6, 9, 8, 3, 7, 7, 12, 9, 6, 9, 8, 7, 6, 11, 14
+};
+
+static_assert(sizeof(ei_classifier_anom_fixed_input_limit) == EI_CLASSIFIER_ANOM_AXIS_SIZE * sizeof(float) &&
+              sizeof(ei_classifier_anom_fixed_centroids) ==
+                  EI_CLASSIFIER_ANOM_CLUSTER_COUNT * EI_CLASSIFIER_ANOM_AXIS_SIZE * sizeof(int8_t) &&
+              sizeof(ei_classifier_anom_fixed_max_error) == EI_CLASSIFIER_ANOM_CLUSTER_COUNT * sizeof(int32_t),
+              "anomaly_clusters_fixed.h doesn't match anomaly_clusters.h, run make -C benchmark anomaly_clusters_fixed");
+
+const ei_classifier_anom_clusters_fixed_t ei_classifier_anom_clusters_fixed = {
+    EI_CLASSIFIER_ANOM_AXIS_SIZE,
+    EI_CLASSIFIER_ANOM_CLUSTER_COUNT,
+    127, // limit
+    4, // frac_bits
+    ei_classifier_anom_fixed_input_limit,
+    ei_classifier_anom_fixed_input_mul,
+    ei_classifier_anom_fixed_scaler_mul,
+    ei_classifier_anom_fixed_scaler_add,
+    ei_classifier_anom_fixed_scaler_shift,
+    ei_classifier_anom_fixed_centroids,
+    NULL,
+    ei_classifier_anom_fixed_max_error
+};
+
+#elif EI_CLASSIFIER_ANOMALY_FIXED_POINT == 16
+
+// largest difference between the fixed-point and the float score
+#define EI_CLASSIFIER_ANOM_FIXED_TOLERANCE    0.00067f
+
+const float ei_classifier_anom_fixed_input_limit[] = { 42.1798096, 23.2818279, 15.7133055 };
+const float ei_classifier_anom_fixed_input_mul[] = { 16777216, 33554432, 67108864 };
+const int32_t ei_classifier_anom_fixed_scaler_mul[] = { 1813778259, 1628689334, 1225530063 };
+const int64_t ei_classifier_anom_fixed_scaler_add[] = { -130616411822933718LL, -119424466249845873LL, -139402436730551552LL };
+const uint8_t ei_classifier_anom_fixed_scaler_shift[] = { 45, 45, 45 };
+
+const int16_t ei_classifier_anom_fixed_centroids[] = {
+    4763, -374, 164,
+    4421, -1456, -1032,
+    -2744, -103, 7478,
+    -3709, -3388, -3947,
+    -2492, 1384, -1127,
+    7588, -47, 3466,
+    5472, -235, -1795,
+    -3035, -1422, -3289,
+    -2061, -1540, 9506,
+    -2850, -1279, 6515,
+    3069, 11506, 3292,
+    -2803, -613, -3377,
+    6343, 2922, 2091,
+    7041, 1136, 1619,
+    -2339, 2497, 153,
+    -3109, -2109, 4692,
+    -134, 15795, -266,
+    3963, 13592, 4892,
+    -1293, 6682, 347,
+    -1796, 13848, -820,
+    -2962, -1473, -2356,
+    -2426, 329, 5608,
+    5122, 1202, -1296,
+    -1787, -737, 11230,
+    3704, -415, 3421,
+    3873, -111, -1462,
+    7615, 390, 5862,
+    -606, 14716, -1578,
+    5795, 2559, -32,
+    5201, -1638, 2630,
+    -523, 4557, 2962,
+    -1034, 4218, 10727
+};
+const int32_t ei_classifier_anom_fixed_max_error[] = {
+    1875, 1613, 1670, 289, 1414, 1772, 2074, 896, 3230, 1626, 1948, 1094, 1838, 1730, 2360, 1715,
+    2022, 1582, 2238, 2121, 861, 1725, 1818, 2976, 2264, 1536, 2299, 1921, 1894, 1628, 2756, 3490
+};
+
+static_assert(sizeof(ei_classifier_anom_fixed_input_limit) == EI_CLASSIFIER_ANOM_AXIS_SIZE * sizeof(float) &&
+              sizeof(ei_classifier_anom_fixed_centroids) ==
+                  EI_CLASSIFIER_ANOM_CLUSTER_COUNT * EI_CLASSIFIER_ANOM_AXIS_SIZE * sizeof(int16_t) &&
+              sizeof(ei_classifier_anom_fixed_max_error) == EI_CLASSIFIER_ANOM_CLUSTER_COUNT * sizeof(int32_t),
+              "anomaly_clusters_fixed.h doesn't match anomaly_clusters.h, run make -C benchmark anomaly_clusters_fixed");
+
+const ei_classifier_anom_clusters_fixed_t ei_classifier_anom_clusters_fixed = {
+    EI_CLASSIFIER_ANOM_AXIS_SIZE,
+    EI_CLASSIFIER_ANOM_CLUSTER_COUNT,
+    32767, // limit
+    12, // frac_bits
+    ei_classifier_anom_fixed_input_limit,
+    ei_classifier_anom_fixed_input_mul,
+    ei_classifier_anom_fixed_scaler_mul,
+    ei_classifier_anom_fixed_scaler_add,
+    ei_classifier_anom_fixed_scaler_shift,
+    NULL,
+    ei_classifier_anom_fixed_centroids,
+    ei_classifier_anom_fixed_max_error
+};
+
+#endif // EI_CLASSIFIER_ANOMALY_FIXED_POINT
+
+#endif // _EI_CLASSIFIER_ANOMALY_CLUSTERS_FIXED_H_
@@ -26,16 +26,33 @@
 #include "model-parameters/model_variables.h"
 #include "edge-impulse-sdk/classifier/ei_run_dsp.h"
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#if EI_CLASSIFIER_DSP_SPECIALIZED
+#include "model-parameters/dsp_config_static.h"
+#endif
 
 const size_t ei_dsp_blocks_size = 1;
 ei_model_dsp_t ei_dsp_blocks[ei_dsp_blocks_size] = {
     { // DSP block 3
         33,
+#if EI_CLASSIFIER_DSP_SPECIALIZED
+        &extract_spectral_analysis_features_static<ei_dsp_config_3_static_t>,
+#else
         &extract_spectral_analysis_features,
+#endif
         (void*)&ei_dsp_config_3,
         ei_dsp_config_3_axes,
         ei_dsp_config_3_axes_size
     }
 };
 
+#if EI_CLASSIFIER_DSP_SPECIALIZED
+// whether an extract function is one of the specialized spectral analysis functions above
+__attribute__((unused)) static bool ei_dsp_is_specialized_spectral_analysis(
+    int (*extract_fn)(ei::signal_t *signal, ei::matrix_t *output_matrix, void *config, const float frequency))
+{
+    return extract_fn == &extract_spectral_analysis_features_static<ei_dsp_config_3_static_t>;
+}
+#endif // EI_CLASSIFIER_DSP_SPECIALIZED
+
 #endif // _EI_CLASSIFIER_DSP_BLOCKS_H_
\ No newline at end of file
@@ -0,0 +1,50 @@
+/* Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EI_CLASSIFIER_DSP_CONFIG_STATIC_H_
+#define _EI_CLASSIFIER_DSP_CONFIG_STATIC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "model-parameters/model_metadata.h"
+#include "model-parameters/model_variables.h"
+
+// Not generated: the shape of the DSP configs in model_variables.h, fixed at compile time
+// for EI_CLASSIFIER_DSP_SPECIALIZED (see extract_spectral_analysis_features_static), and
+// wired into dsp_blocks.h by hand. The number of axes and frames come from the generated
+// headers; the rest is written by hand (the generated configs aren't constant expressions),
+// so keep it in sync when the model is exported again. The specialized functions check it
+// against the config at runtime and return an error on a mismatch.
+
+// ei_dsp_config_3
+struct ei_dsp_config_3_static_t {
+    static constexpr uint16_t implementation_version = 1;
+    static constexpr int axes = ei_dsp_config_3_axes_size;
+    static constexpr size_t frames = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+    static constexpr bool analysis_fft = true;
+    static constexpr int filter_order = 6; // 0 if there's no filter
+    static constexpr bool filter_high_pass = false;
+    static constexpr uint16_t fft_length = 128;
+    static constexpr int spectral_peaks_count = 3;
+    static constexpr int spectral_edges_count = 5;
+};
+
+#endif // _EI_CLASSIFIER_DSP_CONFIG_STATIC_H_
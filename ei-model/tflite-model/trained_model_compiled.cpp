@@ -22,11 +22,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <new>
 #include <vector>
 #include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "tflite-model/trained_model_compiled.h"
 
 #if EI_CLASSIFIER_PRINT_STATE
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
@@ -67,9 +69,6 @@ uint8_t tensor_arena[kTensorArenaSize] ALIGN(16) __attribute__((section(".tensor
 uint8_t* tensor_arena = NULL;
 #endif
 
-static uint8_t* tensor_boundary;
-static uint8_t* current_location;
-
 template <int SZ, class T> struct TfArray {
   int sz; T elem[SZ];
 };
@@ -91,12 +90,6 @@ struct NodeInfo_t { // subset of TfLiteNode used for initialization from constan
   used_operators_e used_op_index;
 };
 
-TfLiteContext ctx{};
-TfLiteTensor tflTensors[11];
-TfLiteEvalTensor tflEvalTensors[11];
-TfLiteRegistration registrations[OP_LAST];
-TfLiteNode tflNodes[4];
-
 const TfArray<2, int> tensor_dimension0 = { 2, { 1,33 } };
 const TfArray<1, float> quant0_scale = { 1, { 0.11322642862796783, } };
 const TfArray<1, int> quant0_zero = { 1, { -128 } };
@@ -214,11 +207,53 @@ const TensorInfo_t tensorData[] = {
   { (TfLiteIntArray*)&inputs2, (TfLiteIntArray*)&outputs2, const_cast<void*>(static_cast<const void*>(&opdata2)), OP_FULLY_CONNECTED, },
   { (TfLiteIntArray*)&inputs3, (TfLiteIntArray*)&outputs3, const_cast<void*>(static_cast<const void*>(&opdata3)), OP_SOFTMAX, },
 };
-static std::vector<void*> overflow_buffers;
+typedef struct {
+  size_t bytes;
+  void *ptr;
+} scratch_buffer_t;
+
+} // namespace
+
+// All mutable state of one model instance, so several instances can run in parallel
+struct trained_model_ctx {
+  TfLiteContext ctx{};
+  TfLiteTensor tflTensors[11];
+  TfLiteEvalTensor tflEvalTensors[11];
+  TfLiteRegistration registrations[OP_LAST];
+  TfLiteNode tflNodes[4];
+  uint8_t* tensor_arena = NULL;
+  bool owns_arena = false;
+  uint8_t* tensor_boundary = NULL;
+  uint8_t* current_location = NULL;
+  std::vector<scratch_buffer_t> scratch_buffers;
+  std::vector<void*> overflow_buffers;
+};
+
+namespace {
+
+// Instance behind the (single instance) trained_model_init / invoke / reset API
+trained_model_ctx default_model;
+
+static inline trained_model_ctx* GetModel(const struct TfLiteContext* ctx) {
+  return static_cast<trained_model_ctx*>(ctx->impl_);
+}
+
+// Location of a tensor in the arena of a model instance
+static inline uint8_t* GetArenaPtr(trained_model_ctx* model, const void* data) {
+#if defined(EI_CLASSIFIER_ALLOCATION_HEAP)
+  // arena tensors are stored as offsets into the arena
+  return model->tensor_arena + (uintptr_t)data;
+#else
+  // arena tensors point into the static arena
+  return model->tensor_arena + ((const uint8_t*)data - tensor_arena);
+#endif
+}
+
 static void * AllocatePersistentBuffer(struct TfLiteContext* ctx,
                                        size_t bytes) {
+  trained_model_ctx* model = GetModel(ctx);
   void *ptr;
-  if (current_location - bytes < tensor_boundary) {
+  if (model->current_location - bytes < model->tensor_boundary) {
     // OK, this will look super weird, but.... we have CMSIS-NN buffers which
     // we cannot calculate beforehand easily.
     ptr = ei_calloc(bytes, 1);
@@ -226,25 +261,21 @@ static void * AllocatePersistentBuffer(struct TfLiteContext* ctx,
       printf("ERR: Failed to allocate persistent buffer of size %d\n", (int)bytes);
       return NULL;
     }
-    overflow_buffers.push_back(ptr);
+    model->overflow_buffers.push_back(ptr);
     return ptr;
   }
 
-  current_location -= bytes;
+  model->current_location -= bytes;
 
-  ptr = current_location;
+  ptr = model->current_location;
   memset(ptr, 0, bytes);
 
   return ptr;
 }
-typedef struct {
-  size_t bytes;
-  void *ptr;
-} scratch_buffer_t;
-static std::vector<scratch_buffer_t> scratch_buffers;
 
 static TfLiteStatus RequestScratchBufferInArena(struct TfLiteContext* ctx, size_t bytes,
                                                 int* buffer_idx) {
+  std::vector<scratch_buffer_t>& scratch_buffers = GetModel(ctx)->scratch_buffers;
   scratch_buffer_t b;
   b.bytes = bytes;
 
@@ -261,6 +292,7 @@ static TfLiteStatus RequestScratchBufferInArena(struct TfLiteContext* ctx, size_
 }
 
 static void* GetScratchBuffer(struct TfLiteContext* ctx, int buffer_idx) {
+  std::vector<scratch_buffer_t>& scratch_buffers = GetModel(ctx)->scratch_buffers;
   if (buffer_idx > static_cast<int>(scratch_buffers.size()) - 1) {
     return NULL;
   }
@@ -269,28 +301,44 @@ static void* GetScratchBuffer(struct TfLiteContext* ctx, int buffer_idx) {
 
 static TfLiteTensor* GetTensor(const struct TfLiteContext* context,
                                int tensor_idx) {
-  return &tflTensors[tensor_idx];
+  return &GetModel(context)->tflTensors[tensor_idx];
 }
 
 static TfLiteEvalTensor* GetEvalTensor(const struct TfLiteContext* context,
                                        int tensor_idx) {
-  return &tflEvalTensors[tensor_idx];
+  return &GetModel(context)->tflEvalTensors[tensor_idx];
 }
 
 } // namespace
 
-TfLiteStatus trained_model_init( void*(*alloc_fnc)(size_t,size_t) ) {
-#ifdef EI_CLASSIFIER_ALLOCATION_HEAP
-  tensor_arena = (uint8_t*) alloc_fnc(16, kTensorArenaSize);
-  if (!tensor_arena) {
-    printf("ERR: failed to allocate tensor arena\n");
-    return kTfLiteError;
-  }
+static TfLiteStatus InitModel(trained_model_ctx* model, void*(*alloc_fnc)(size_t,size_t), bool use_static_arena) {
+  TfLiteContext& ctx = model->ctx;
+  TfLiteTensor* tflTensors = model->tflTensors;
+  TfLiteEvalTensor* tflEvalTensors = model->tflEvalTensors;
+  TfLiteRegistration* registrations = model->registrations;
+  TfLiteNode* tflNodes = model->tflNodes;
+
+#if defined(EI_CLASSIFIER_ALLOCATION_HEAP)
+  (void)use_static_arena;
 #else
-  memset(tensor_arena, 0, kTensorArenaSize);
+  if (use_static_arena) {
+    model->tensor_arena = tensor_arena;
+    model->owns_arena = false;
+    memset(model->tensor_arena, 0, kTensorArenaSize);
+  }
+  else
 #endif
-  tensor_boundary = tensor_arena;
-  current_location = tensor_arena + kTensorArenaSize;
+  {
+    model->tensor_arena = (uint8_t*) alloc_fnc(16, kTensorArenaSize);
+    if (!model->tensor_arena) {
+      printf("ERR: failed to allocate tensor arena\n");
+      return kTfLiteError;
+    }
+    model->owns_arena = true;
+  }
+  model->tensor_boundary = model->tensor_arena;
+  model->current_location = model->tensor_arena + kTensorArenaSize;
+  ctx.impl_ = model;
   ctx.AllocatePersistentBuffer = &AllocatePersistentBuffer;
   ctx.RequestScratchBufferInArena = &RequestScratchBufferInArena;
   ctx.GetScratchBuffer = &GetScratchBuffer;
@@ -312,9 +360,8 @@ TfLiteStatus trained_model_init( void*(*alloc_fnc)(size_t,size_t) ) {
     tflTensors[i].dims = tensorData[i].dims;
     tflEvalTensors[i].dims = tensorData[i].dims;
 
-#if defined(EI_CLASSIFIER_ALLOCATION_HEAP)
     if(tflTensors[i].allocation_type == kTfLiteArenaRw){
-      uint8_t* start = (uint8_t*) ((uintptr_t)tensorData[i].data + (uintptr_t) tensor_arena);
+      uint8_t* start = GetArenaPtr(model, tensorData[i].data);
 
      tflTensors[i].data.data =  start;
      tflEvalTensors[i].data.data =  start;
@@ -323,10 +370,6 @@ TfLiteStatus trained_model_init( void*(*alloc_fnc)(size_t,size_t) ) {
        tflTensors[i].data.data = tensorData[i].data;
        tflEvalTensors[i].data.data = tensorData[i].data;
     }
-#else
-    tflTensors[i].data.data = tensorData[i].data;
-    tflEvalTensors[i].data.data = tensorData[i].data;
-#endif // EI_CLASSIFIER_ALLOCATION_HEAP
     tflTensors[i].quantization = tensorData[i].quantization;
     if (tflTensors[i].quantization.type == kTfLiteAffineQuantization) {
       TfLiteAffineQuantization const* quant = ((TfLiteAffineQuantization const*)(tensorData[i].quantization.params));
@@ -335,12 +378,12 @@ TfLiteStatus trained_model_init( void*(*alloc_fnc)(size_t,size_t) ) {
     }
     if (tflTensors[i].allocation_type == kTfLiteArenaRw) {
       auto data_end_ptr = (uint8_t*)tflTensors[i].data.data + tensorData[i].bytes;
-      if (data_end_ptr > tensor_boundary) {
-        tensor_boundary = data_end_ptr;
+      if (data_end_ptr > model->tensor_boundary) {
+        model->tensor_boundary = data_end_ptr;
       }
     }
   }
-  if (tensor_boundary > current_location /* end of arena size */) {
+  if (model->tensor_boundary > model->current_location /* end of arena size */) {
     printf("ERR: tensor arena is too small, does not fit model - even without scratch buffers\n");
     return kTfLiteError;
   }
@@ -368,21 +411,24 @@ if (registrations[nodeData[i].used_op_index].init) {
   return kTfLiteOk;
 }
 
-static const int inTensorIndices[] = {
-  0, 
-};
-TfLiteTensor* trained_model_input(int index) {
-  return &ctx.tensors[inTensorIndices[index]];
-}
-
-static const int outTensorIndices[] = {
-  10, 
-};
-TfLiteTensor* trained_model_output(int index) {
-  return &ctx.tensors[outTensorIndices[index]];
+static TfLiteStatus ResetModel(trained_model_ctx* model, void (*free_fnc)(void* ptr)) {
+  if (model->owns_arena) {
+    free_fnc(model->tensor_arena);
+  }
+  model->tensor_arena = NULL;
+  model->owns_arena = false;
+  model->scratch_buffers.clear();
+  for (size_t ix = 0; ix < model->overflow_buffers.size(); ix++) {
+    free(model->overflow_buffers[ix]);
+  }
+  model->overflow_buffers.clear();
+  return kTfLiteOk;
 }
 
-TfLiteStatus trained_model_invoke() {
+static TfLiteStatus InvokeModel(trained_model_ctx* model) {
+  TfLiteContext& ctx = model->ctx;
+  TfLiteRegistration* registrations = model->registrations;
+  TfLiteNode* tflNodes = model->tflNodes;
   for(size_t i = 0; i < 4; ++i) {
     TfLiteStatus status = registrations[nodeData[i].used_op_index].invoke(&ctx, &tflNodes[i]);
 
@@ -395,7 +441,7 @@ TfLiteStatus trained_model_invoke() {
       size_t data_ptr = (size_t)d.data;
 
       if (d.allocation_type == kTfLiteArenaRw) {
-        data_ptr = (size_t)tensor_arena + data_ptr;
+        data_ptr = (size_t)GetArenaPtr(model, d.data);
       }
 
       if (d.type == TfLiteType::kTfLiteInt8) {
@@ -423,7 +469,7 @@ TfLiteStatus trained_model_invoke() {
       size_t data_ptr = (size_t)d.data;
 
       if (d.allocation_type == kTfLiteArenaRw) {
-        data_ptr = (size_t)tensor_arena + data_ptr;
+        data_ptr = (size_t)GetArenaPtr(model, d.data);
       }
 
       if (d.type == TfLiteType::kTfLiteInt8) {
@@ -452,14 +498,63 @@ TfLiteStatus trained_model_invoke() {
   return kTfLiteOk;
 }
 
+TfLiteStatus trained_model_init( void*(*alloc_fnc)(size_t,size_t) ) {
+  return InitModel(&default_model, alloc_fnc, true);
+}
+
+static const int inTensorIndices[] = {
+  0, 
+};
+TfLiteTensor* trained_model_input(int index) {
+  return &default_model.ctx.tensors[inTensorIndices[index]];
+}
+
+static const int outTensorIndices[] = {
+  10, 
+};
+TfLiteTensor* trained_model_output(int index) {
+  return &default_model.ctx.tensors[outTensorIndices[index]];
+}
+
+TfLiteStatus trained_model_invoke() {
+  return InvokeModel(&default_model);
+}
+
 TfLiteStatus trained_model_reset( void (*free_fnc)(void* ptr) ) {
-#ifdef EI_CLASSIFIER_ALLOCATION_HEAP
-  free_fnc(tensor_arena);
-#endif
-  scratch_buffers.clear();
-  for (size_t ix = 0; ix < overflow_buffers.size(); ix++) {
-    free(overflow_buffers[ix]);
+  return ResetModel(&default_model, free_fnc);
+}
+
+trained_model_ctx_t* trained_model_create( void*(*alloc_fnc)(size_t,size_t), void (*free_fnc)(void* ptr) ) {
+  trained_model_ctx_t* model = new (std::nothrow) trained_model_ctx();
+  if (!model) {
+    printf("ERR: failed to allocate model context\n");
+    return NULL;
   }
-  overflow_buffers.clear();
-  return kTfLiteOk;
+  if (InitModel(model, alloc_fnc, false) != kTfLiteOk) {
+    ResetModel(model, free_fnc);
+    delete model;
+    return NULL;
+  }
+  return model;
+}
+
+TfLiteTensor* trained_model_input(trained_model_ctx_t* model, int index) {
+  return &model->ctx.tensors[inTensorIndices[index]];
+}
+
+TfLiteTensor* trained_model_output(trained_model_ctx_t* model, int index) {
+  return &model->ctx.tensors[outTensorIndices[index]];
+}
+
+TfLiteStatus trained_model_invoke(trained_model_ctx_t* model) {
+  return InvokeModel(model);
+}
+
+TfLiteStatus trained_model_destroy(trained_model_ctx_t* model, void (*free_fnc)(void* ptr) ) {
+  if (!model) {
+    return kTfLiteOk;
+  }
+  TfLiteStatus status = ResetModel(model, free_fnc);
+  delete model;
+  return status;
 }
@@ -36,6 +36,21 @@ TfLiteStatus trained_model_invoke();
 //Frees memory allocated
 TfLiteStatus trained_model_reset( void (*free)(void* ptr) );
 
+// Independent model instance (own arena, tensors and kernel state), so that
+// several inferences can be in flight at the same time (one per instance).
+typedef struct trained_model_ctx trained_model_ctx_t;
+
+// Creates and prepares a new model instance, returns NULL on failure.
+trained_model_ctx_t *trained_model_create( void*(*alloc_fnc)(size_t,size_t), void (*free)(void* ptr) );
+// Returns the input tensor with the given index of a model instance.
+TfLiteTensor *trained_model_input(trained_model_ctx_t *ctx, int index);
+// Returns the output tensor with the given index of a model instance.
+TfLiteTensor *trained_model_output(trained_model_ctx_t *ctx, int index);
+// Runs inference on a model instance.
+TfLiteStatus trained_model_invoke(trained_model_ctx_t *ctx);
+// Frees a model instance and all memory allocated by it.
+TfLiteStatus trained_model_destroy(trained_model_ctx_t *ctx, void (*free)(void* ptr) );
+
 
 // Returns the number of input tensors.
 inline size_t trained_model_inputs() {
@@ -76,6 +76,8 @@ int main(void)
 
     signal.total_length = sizeof(features)/sizeof(features[0]);
     signal.get_data = &get_feature_data;
+    // features are in memory, let the DSP blocks read them directly
+    signal.buffer = features;
 
     while(1)
     {